@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <list>
 
 #include <boost/io/ios_state.hpp>
@@ -41,14 +42,77 @@ THE SOFTWARE.
 #include <boost/make_shared.hpp>
 #include <boost/foreach.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/utility/enable_if.hpp>
 
 #include <amgcl/backend/builtin.hpp>
+#include <amgcl/relaxation/interface.hpp>
 #include <amgcl/solver/detail/default_inner_product.hpp>
 #include <amgcl/util.hpp>
+#include <amgcl/detail/decoupled_rows.hpp>
+#include <amgcl/detail/symmetric_scaling.hpp>
 
 /// Primary namespace.
 namespace amgcl {
 
+namespace relaxation {
+
+/// Sends additional information about a smoother instance to output stream.
+/**
+ * Does nothing by default. Relaxation schemes that have something to report
+ * (e.g. the size of incomplete factors) provide an overload in the
+ * amgcl::relaxation namespace.
+ */
+template <class Relax>
+void print_info(std::ostream&, const Relax&) {}
+
+} // namespace relaxation
+
+namespace coarsening {
+namespace detail {
+
+// Checks if the coarsening parameters have aggressive_levels field.
+template <class Params>
+struct has_aggressive_levels {
+    typedef char yes[1];
+    typedef char no[2];
+
+    template <class T, T> struct check;
+
+    template <class P>
+    static yes& test(check<unsigned P::*, &P::aggressive_levels>*);
+
+    template <class P>
+    static no& test(...);
+
+    static const bool value = sizeof(test<Params>(0)) == sizeof(yes);
+};
+
+/// Returns true if the next level is built with aggressive coarsening.
+template <class Params>
+typename boost::enable_if_c<has_aggressive_levels<Params>::value, bool>::type
+aggressive_level(const Params &prm) {
+    return prm.aggressive_levels > 0;
+}
+
+template <class Params>
+typename boost::disable_if_c<has_aggressive_levels<Params>::value, bool>::type
+aggressive_level(const Params&) {
+    return false;
+}
+
+/// Reports the number of iterations made by the outer solver.
+/**
+ * Coarsenings that reuse data across hierarchy rebuilds (see
+ * cached_aggregates) specialize this to decide when the data is outdated.
+ */
+template <class Coarsening>
+struct solver_feedback {
+    static void apply(const typename Coarsening::params&, size_t) {}
+};
+
+} // namespace detail
+} // namespace coarsening
+
 /// Algebraic multigrid method.
 /**
  * AMG is one the most effective methods for solution of large sparse
@@ -172,6 +236,8 @@ class amg {
             sort_rows(*A);
 
             while( backend::rows(*A) > prm.coarse_enough) {
+                bool aggressive = coarsening::detail::aggressive_level(prm.coarsening);
+
                 TIC("transfer operators");
                 boost::tie(P, R) = Coarsening::transfer_operators(
                         *A, prm.coarsening);
@@ -182,7 +248,7 @@ class amg {
                 TOC("transfer operators");
 
                 TIC("move to backend")
-                levels.push_back( level(A, P, R, prm) );
+                levels.push_back( level(A, P, R, prm, levels.size(), aggressive) );
                 TOC("move to backend")
 
                 TIC("coarse operator");
@@ -233,7 +299,7 @@ class amg {
         {
             backend::clear(x);
             for(unsigned i = 0; i < prm.pre_cycles; ++i)
-                cycle(levels.begin(), rhs, x);
+                cycle(levels.begin(), rhs, x, i == 0);
         }
 
         /// Returns the system matrix from the finest level.
@@ -258,11 +324,16 @@ class amg {
 
             size_t m_rows, m_nonzeros;
 
+            // The transfer operators were built with aggressive coarsening.
+            bool aggressive;
+
             level(
                     boost::shared_ptr<build_matrix> a,
                     boost::shared_ptr<build_matrix> p,
                     boost::shared_ptr<build_matrix> r,
-                    const params &prm
+                    const params &prm,
+                    unsigned depth,
+                    bool aggressive
                  ) :
                 A( Backend::copy_matrix(a, prm.backend) ),
                 P( Backend::copy_matrix(p, prm.backend) ),
@@ -270,9 +341,11 @@ class amg {
                 f( Backend::create_vector(backend::rows(*a), prm.backend) ),
                 u( Backend::create_vector(backend::rows(*a), prm.backend) ),
                 t( Backend::create_vector(backend::rows(*a), prm.backend) ),
-                relax( new relax_type(*a, prm.relax, prm.backend) ),
+                relax( relaxation::level_factory<relax_type>::create(
+                            *a, prm.relax, prm.backend, depth) ),
                 m_rows( backend::rows(*A) ),
-                m_nonzeros( backend::nonzeros(*A) )
+                m_nonzeros( backend::nonzeros(*A) ),
+                aggressive(aggressive)
             { }
 
             level(
@@ -284,7 +357,8 @@ class amg {
                 u( Backend::create_vector(backend::rows(*a), prm.backend) ),
                 solve( Backend::create_solver(a, prm.backend) ),
                 m_rows( backend::rows(*a) ),
-                m_nonzeros( backend::nonzeros(*a) )
+                m_nonzeros( backend::nonzeros(*a) ),
+                aggressive(false)
             {
                 if (no_finer_levels)
                     A = Backend::copy_matrix(a, prm.backend);
@@ -304,7 +378,7 @@ class amg {
         std::list<level> levels;
 
         template <class Vec1, class Vec2>
-        void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x) const
+        void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x, bool zero_x = false) const
         {
             level_iterator nxt = lvl; ++nxt;
 
@@ -314,21 +388,16 @@ class amg {
                 TOC("coarse");
             } else {
                 for (size_t j = 0; j < prm.ncycle; ++j) {
-                    TIC("relax");
-                    for(size_t i = 0; i < prm.npre; ++i)
-                        lvl->relax->apply_pre(*lvl->A, rhs, x, *lvl->t, prm.relax);
-                    TOC("relax");
-
-                    TIC("residual");
-                    backend::residual(rhs, *lvl->A, x, *lvl->t);
-                    TOC("residual");
+                    pre_relax_and_residual(*lvl, rhs, x, zero_x && j == 0,
+                            typename relaxation::provides_apply_pre_and_residual<relax_type>::type()
+                            );
 
                     TIC("restrict");
                     backend::spmv(1, *lvl->R, *lvl->t, 0, *nxt->f);
                     TOC("restrict");
 
                     backend::clear(*nxt->u);
-                    cycle(nxt, *nxt->f, *nxt->u);
+                    cycle(nxt, *nxt->f, *nxt->u, true);
 
                     TIC("prolongate");
                     backend::spmv(1, *lvl->P, *nxt->u, 1, x);
@@ -342,6 +411,42 @@ class amg {
             }
         }
 
+        // Pre-relaxation followed by residual computation.
+        template <class Vec1, class Vec2>
+        void pre_relax_and_residual(const level &lvl, const Vec1 &rhs, Vec2 &x,
+                bool, boost::false_type) const
+        {
+            TIC("relax");
+            for(size_t i = 0; i < prm.npre; ++i)
+                lvl.relax->apply_pre(*lvl.A, rhs, x, *lvl.t, prm.relax);
+            TOC("relax");
+
+            TIC("residual");
+            backend::residual(rhs, *lvl.A, x, *lvl.t);
+            TOC("residual");
+        }
+
+        // The relaxation computes the residual as part of the last
+        // pre-relaxation step.
+        template <class Vec1, class Vec2>
+        void pre_relax_and_residual(const level &lvl, const Vec1 &rhs, Vec2 &x,
+                bool zero_x, boost::true_type) const
+        {
+            if (prm.npre == 0) {
+                TIC("residual");
+                backend::residual(rhs, *lvl.A, x, *lvl.t);
+                TOC("residual");
+                return;
+            }
+
+            TIC("relax");
+            for(size_t i = 1; i < prm.npre; ++i, zero_x = false)
+                lvl.relax->apply_pre(*lvl.A, rhs, x, *lvl.t, prm.relax);
+
+            lvl.relax->apply_pre_and_residual(*lvl.A, rhs, x, *lvl.t, prm.relax, zero_x);
+            TOC("relax");
+        }
+
     template <class B, class C, template <class> class R>
     friend std::ostream& operator<<(std::ostream &os, const amg<B, C, R> &a);
 };
@@ -376,9 +481,31 @@ std::ostream& operator<<(std::ostream &os, const amg<B, C, R> &a)
             << std::setw(15) << lvl.nonzeros() << " ("
             << std::setw(5) << std::fixed << std::setprecision(2)
             << 100.0 * lvl.nonzeros() / sum_nnz
-            << "%)" << std::endl;
+            << "%)" << (lvl.aggressive ? " aggressive" : "") << std::endl;
     }
 
+    std::ostringstream relax_info;
+
+    depth = 0;
+    BOOST_FOREACH(const level &lvl, a.levels) {
+        if (lvl.relax) {
+            std::ostringstream info;
+
+            using amgcl::relaxation::print_info;
+            print_info(info, *lvl.relax);
+
+            if (!info.str().empty())
+                relax_info << std::setw(5) << depth << "   " << info.str() << std::endl;
+        }
+
+        ++depth;
+    }
+
+    if (!relax_info.str().empty())
+        os << "\nlevel   relaxation\n"
+           << "---------------------------------\n"
+           << relax_info.str();
+
     return os;
 }
 
@@ -396,9 +523,28 @@ class make_solver {
         typedef amgcl::amg<Backend, Coarsening, Relax> AMG;
         typedef IterativeSolver<Backend, solver::detail::default_inner_product> Solver;
 
+        typedef detail::decoupled_rows<Backend>    Decoupled;
+        typedef detail::symmetric_scaling<Backend> Scaling;
+
         struct params {
             typename AMG::params amg;
             typename Solver::params solver;
+
+            /// Elimination of the decoupled (e.g. Dirichlet) rows.
+            /**
+             * When enabled, the rows that are decoupled from the rest of the
+             * system are condensed out before the hierarchy setup, and their
+             * solution is reinserted after each solve.
+             */
+            typename Decoupled::params eliminate;
+
+            /// Symmetric scaling of the system.
+            /**
+             * When enabled, the hierarchy is built for the scaled matrix
+             * \f$DAD\f$. The right-hand side and the solution are scaled
+             * transparently.
+             */
+            typename Scaling::params scaling;
         };
 
         /// Constructs the AMG hierarchy and creates iterative solver.
@@ -407,9 +553,30 @@ class make_solver {
                 const Matrix &A,
                 const params &prm = params()
                 )
-            : P(A, prm.amg),
-              S(backend::rows(A), prm.solver, prm.amg.backend)
-        {}
+            : n(backend::rows(A)), m(0), prm(prm)
+        {
+            init(A);
+        }
+
+        /// Rebuilds the AMG hierarchy for the new system matrix.
+        /**
+         * The new matrix should have the same size as the original one.
+         * With cached_aggregates, the aggregates of the previous hierarchy
+         * are reused as long as the sparsity pattern of the matrix is the
+         * same and the strength of connections and the convergence of the
+         * iterative solver have not drifted too far.
+         *
+         * The symmetric scaling computed for the original matrix is reused.
+         */
+        template <class Matrix>
+        void rebuild(const Matrix &A) {
+            precondition(
+                    backend::rows(A) == n,
+                    "Matrix size should not change on rebuild"
+                    );
+
+            init(A);
+        }
 
         /// Solves the linear system for the given system matrix.
         /**
@@ -423,6 +590,11 @@ class make_solver {
          * a strong chance that AMG built for one time step will act as a
          * reasonably good preconditioner for several subsequent time steps
          * \cite Demidov2012.
+         *
+         * When the decoupled rows are eliminated, the same rows should be
+         * decoupled in the new matrix. The elimination and the scaling are
+         * applied to the new matrix as backend operations, so the matrix is
+         * never copied or converted.
          */
         template <class Matrix, class Vec1, class Vec2>
         boost::tuple<size_t, value_type> operator()(
@@ -435,7 +607,14 @@ class make_solver {
 #endif
                 ) const
         {
-            return S(A, P, rhs, x);
+            if (!E) return feedback( solve_scaled(A, rhs, x) );
+
+            E->reduce(A, rhs, x);
+            boost::tuple<size_t, value_type> cnv = solve_scaled(
+                    E->reduced(A), E->rhs(), E->x());
+            E->expand(rhs, x);
+
+            return feedback(cnv);
         }
 
         /// Solves the linear system for the given right-hand side.
@@ -453,7 +632,13 @@ class make_solver {
 #endif
                 ) const
         {
-            return S(P, rhs, x);
+            if (!E) return feedback( solve_scaled(rhs, x) );
+
+            E->reduce(rhs, x);
+            boost::tuple<size_t, value_type> cnv = solve_scaled(E->rhs(), E->x());
+            E->expand(rhs, x);
+
+            return feedback(cnv);
         }
 
         /// Acts as a preconditioner.
@@ -476,18 +661,100 @@ class make_solver {
         }
 
         /// Reference to the constructed AMG hierarchy.
+        /**
+         * When the decoupled rows are eliminated or the system is scaled,
+         * the hierarchy is built for the reduced or the scaled system.
+         */
         const AMG& amg() const {
-            return P;
+            return *P;
         }
 
         /// Reference to the iterative solver.
         const Solver& solver() const {
-            return S;
+            return *S;
         }
 
     private:
-        AMG    P;
-        Solver S;
+        size_t n, m;
+        params prm;
+
+        boost::shared_ptr<Decoupled> E;
+        boost::shared_ptr<Scaling>   Q;
+        boost::shared_ptr<AMG>       P;
+        boost::shared_ptr<Solver>    S;
+
+        template <class Matrix>
+        void init(const Matrix &A) {
+            E.reset();
+
+            if (prm.eliminate.enable) {
+                E = boost::make_shared<Decoupled>(A, prm.eliminate, prm.amg.backend);
+                if (!E->active()) E.reset();
+            }
+
+            if (E) {
+                setup(E->system_matrix());
+                E->release();
+            } else {
+                setup(A);
+            }
+
+            // The solver is kept unless the size of the system has changed.
+            size_t rows = E ? E->size() : n;
+            if (!S || rows != m) {
+                m = rows;
+                S = boost::make_shared<Solver>(m, prm.solver, prm.amg.backend);
+            }
+        }
+
+        template <class Matrix>
+        void setup(const Matrix &A) {
+            if (prm.scaling.type == detail::scaling::none) {
+                Q.reset();
+                P = boost::make_shared<AMG>(A, prm.amg);
+                return;
+            }
+
+            // The scaling is kept for the numeric rebuilds.
+            if (!Q || Q->size() != backend::rows(A))
+                Q = boost::make_shared<Scaling>(A, prm.scaling, prm.amg.backend);
+
+            P = boost::make_shared<AMG>(*Q->scaled_matrix(A), prm.amg);
+        }
+
+        // Solves the system with the matrix of the hierarchy.
+        template <class Vec1, class Vec2>
+        boost::tuple<size_t, value_type>
+        solve_scaled(const Vec1 &rhs, Vec2 &x) const {
+            if (!Q) return (*S)(*P, rhs, x);
+
+            Q->scale(rhs, x);
+            boost::tuple<size_t, value_type> cnv = (*S)(*P, Q->rhs(), Q->x());
+            Q->unscale(x);
+
+            return cnv;
+        }
+
+        // Solves the system with the given matrix.
+        template <class Matrix, class Vec1, class Vec2>
+        boost::tuple<size_t, value_type>
+        solve_scaled(const Matrix &A, const Vec1 &rhs, Vec2 &x) const {
+            if (!Q) return (*S)(A, *P, rhs, x);
+
+            Q->scale(rhs, x);
+            boost::tuple<size_t, value_type> cnv = (*S)(
+                    Q->scaled(A), *P, Q->rhs(), Q->x());
+            Q->unscale(x);
+
+            return cnv;
+        }
+
+        boost::tuple<size_t, value_type>
+        feedback(const boost::tuple<size_t, value_type> &cnv) const {
+            coarsening::detail::solver_feedback<Coarsening>::apply(
+                    prm.amg.coarsening, boost::get<0>(cnv));
+            return cnv;
+        }
 };
 
 } // namespace amgcl
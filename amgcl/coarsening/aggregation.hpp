@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/detail/scaled_galerkin.hpp>
 #include <amgcl/coarsening/tentative_prolongation.hpp>
+#include <amgcl/coarsening/detail/aggregates.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -93,18 +94,32 @@ struct aggregation {
          */
         float over_interp;
 
-        params() : over_interp(1.5f) { }
+        /// Number of the first levels that use aggressive coarsening.
+        /**
+         * On these levels the aggregates are merged into aggregates of
+         * aggregates: the same aggregation scheme is applied once more to the
+         * Galerkin operator of the piecewise-constant prolongation. This
+         * greatly reduces the size and the density of the coarse levels at
+         * the cost of weaker convergence.
+         *
+         * The value is decremented each time an aggressive level is built.
+         */
+        unsigned aggressive_levels;
+
+        params() : over_interp(1.5f), aggressive_levels(0) { }
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_CHILD(p, aggr),
               AMGCL_PARAMS_IMPORT_CHILD(p, nullspace),
-              AMGCL_PARAMS_IMPORT_VALUE(p, over_interp)
+              AMGCL_PARAMS_IMPORT_VALUE(p, over_interp),
+              AMGCL_PARAMS_IMPORT_VALUE(p, aggressive_levels)
         {}
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_CHILD(p, path, aggr);
             AMGCL_PARAMS_EXPORT_CHILD(p, path, nullspace);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, over_interp);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, aggressive_levels);
         }
     };
 
@@ -127,6 +142,12 @@ struct aggregation {
 
         TIC("aggregates");
         Aggregates aggr(A, prm.aggr);
+
+        if (prm.aggressive_levels > 0) {
+            --prm.aggressive_levels;
+            detail::aggregate_aggregates(A, prm.aggr, aggr);
+        }
+        detail::coarse_aggregates_params<Aggregates>::apply(prm.aggr, aggr);
         TOC("aggregates");
 
         TIC("interpolation");
@@ -0,0 +1,347 @@
+#ifndef AMGCL_COARSENING_CACHED_AGGREGATES_HPP
+#define AMGCL_COARSENING_CACHED_AGGREGATES_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/cached_aggregates.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Reuse of aggregates across hierarchy rebuilds.
+ */
+
+#include <vector>
+#include <map>
+#include <cmath>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <amgcl/amgcl.hpp>
+#include <amgcl/util.hpp>
+#include <amgcl/backend/builtin.hpp>
+
+namespace amgcl {
+namespace coarsening {
+
+/// Aggregates that are reused across hierarchy rebuilds.
+/**
+ * Wraps another aggregation scheme (plain_aggregates or
+ * pointwise_aggregates) and keeps its results (the aggregate ids and the
+ * strong connections) for each level of the hierarchy. When the hierarchy is
+ * rebuilt for a new matrix with the same sparsity pattern (e.g. on the next
+ * time step with make_solver::rebuild()), the stored aggregates are reused,
+ * so that only the transfer operators and the coarse operators are
+ * recomputed.
+ *
+ * The aggregates of a level are recomputed when the strength of
+ * connections drifts too far from the one the aggregates were built for.
+ * The drift is measured as
+ * \f[
+ *   \frac{\sum_{ij} |s_{ij} - s^0_{ij}|}{\sum_{ij} s^0_{ij}},
+ *   \quad s_{ij} = \frac{a_{ij}^2}{|a_{ii} a_{jj}|},
+ * \f]
+ * where \f$s^0\f$ is the strength at the time of aggregation. The aggregates
+ * of the coarser levels are discarded together with the recomputed ones.
+ * Additionally, when used with make_solver, all aggregates are discarded
+ * once the number of iterations of the outer solver grows by the factor of
+ * params::max_iter_growth relative to the first solve after a full
+ * aggregation.
+ *
+ * The cache is shared between the copies of the parameters, so a single
+ * parameter instance should not be used for several hierarchies at once.
+ * The wrapped scheme should not keep level-dependent data in its
+ * parameters (as geometric_aggregates does).
+ *
+ * \ingroup aggregates
+ */
+template <class Base>
+struct cached_aggregates {
+    /// Aggregates stored for each level of the hierarchy.
+    struct cache {
+        struct entry {
+            size_t                 nnz;
+            boost::uint64_t        pattern;
+            size_t                 count;
+            std::vector<ptrdiff_t> id;
+            std::vector<char>      strong_connection;
+            std::vector<float>     strength;
+        };
+
+        // Levels are identified by their size, which decreases
+        // monotonically along the hierarchy.
+        std::map<size_t, entry> levels;
+
+        // Iterations of the first solve after a full aggregation.
+        size_t base_iters;
+
+        cache() : base_iters(0) {}
+
+        /// Discards all stored aggregates.
+        void clear() {
+            levels.clear();
+            base_iters = 0;
+        }
+    };
+
+    /// Aggregation parameters.
+    struct params : Base::params {
+        /// Storage for the aggregates.
+        /**
+         * Shared between the copies of the parameters. Setting this to
+         * null disables the reuse.
+         */
+        boost::shared_ptr<cache> store;
+
+        /// Maximum relative change of connection strength.
+        /**
+         * The aggregates of a level are reused when the strength of
+         * connections has changed by less than this since the aggregation.
+         * Zero value disables the check, so that the aggregates are reused
+         * as long as the sparsity pattern is the same.
+         */
+        float max_drift;
+
+        /// Maximum growth of the outer solver iteration count.
+        /**
+         * Zero value disables the check.
+         */
+        float max_iter_growth;
+
+        params()
+            : store(boost::make_shared<cache>()),
+              max_drift(0.1f), max_iter_growth(1.5f)
+        {}
+
+        params(const boost::property_tree::ptree &p)
+            : Base::params(p),
+              store(boost::make_shared<cache>()),
+              AMGCL_PARAMS_IMPORT_VALUE(p, max_drift),
+              AMGCL_PARAMS_IMPORT_VALUE(p, max_iter_growth)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            Base::params::get(p, path);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, max_drift);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, max_iter_growth);
+        }
+    };
+
+    static const ptrdiff_t undefined = -1;
+    static const ptrdiff_t removed   = -2;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::count
+    size_t count;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::strong_connection
+    std::vector<char> strong_connection;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::id
+    std::vector<ptrdiff_t> id;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::plain_aggregates
+    template <class Matrix>
+    cached_aggregates(const Matrix &A, const params &prm) : count(0)
+    {
+        if (!prm.store) {
+            aggregate(A, prm);
+            return;
+        }
+
+        typedef typename cache::entry entry;
+        typedef typename std::map<size_t, entry>::iterator iterator;
+
+        const size_t n = backend::rows(A);
+
+        cache &c = *prm.store;
+
+        iterator e = c.levels.find(n);
+
+        if (e != c.levels.end() && reusable(A, e->second, prm.max_drift)) {
+            count             = e->second.count;
+            id                = e->second.id;
+            strong_connection = e->second.strong_connection;
+            return;
+        }
+
+        aggregate(A, prm);
+
+        // The coarser levels were built from the outdated aggregates.
+        c.levels.erase(c.levels.begin(), c.levels.upper_bound(n));
+
+        // This is a full aggregation, if nothing finer is stored.
+        if (c.levels.empty()) c.base_iters = 0;
+
+        entry &r = c.levels[n];
+        r.nnz               = backend::nonzeros(A);
+        r.pattern           = pattern(A);
+        r.count             = count;
+        r.id                = id;
+        r.strong_connection = strong_connection;
+
+        if (prm.max_drift > 0) strength(A, r.strength);
+    }
+
+    private:
+        template <class Matrix>
+        void aggregate(const Matrix &A, const params &prm) {
+            Base aggr(A, prm);
+
+            count = aggr.count;
+            strong_connection.swap(aggr.strong_connection);
+            id.swap(aggr.id);
+        }
+
+        // Hash of the position of a nonzero entry (splitmix64 finalizer).
+        static boost::uint64_t hash(ptrdiff_t i, ptrdiff_t j) {
+            boost::uint64_t k = (static_cast<boost::uint64_t>(i) << 32)
+                ^ static_cast<boost::uint64_t>(j);
+
+            k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+            return k ^ (k >> 31);
+        }
+
+        // Hash of the sparsity pattern.
+        template <class Matrix>
+        static boost::uint64_t pattern(const Matrix &A) {
+            const ptrdiff_t n = backend::rows(A);
+
+            boost::uint64_t h = 0;
+
+#pragma omp parallel for reduction(+:h)
+            for(ptrdiff_t i = 0; i < n; ++i)
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    h += hash(i, A.col[j]);
+
+            return h;
+        }
+
+        // Inverse absolute values of the diagonal.
+        template <class Matrix>
+        static std::vector<typename backend::value_type<Matrix>::type>
+        inverse_diagonal(const Matrix &A) {
+            typedef typename backend::value_type<Matrix>::type V;
+
+            const ptrdiff_t n = backend::rows(A);
+
+            std::vector<V> dia = backend::diagonal(A);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                dia[i] = dia[i] == 0 ? V() : 1 / std::abs(dia[i]);
+
+            return dia;
+        }
+
+        // Squared strength of each connection (zero for the diagonal).
+        template <class Matrix>
+        static void strength(const Matrix &A, std::vector<float> &s) {
+            typedef typename backend::value_type<Matrix>::type V;
+
+            const ptrdiff_t n = backend::rows(A);
+
+            std::vector<V> dinv = inverse_diagonal(A);
+            s.resize(backend::nonzeros(A));
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    V         v = A.val[j];
+
+                    s[j] = c == i ? 0.0f : static_cast<float>(v * v * dinv[i] * dinv[c]);
+                }
+            }
+        }
+
+        // Checks the sparsity pattern and the strength drift in a single
+        // pass over the matrix.
+        template <class Matrix>
+        static bool reusable(const Matrix &A,
+                const typename cache::entry &e, float max_drift)
+        {
+            typedef typename backend::value_type<Matrix>::type V;
+
+            const ptrdiff_t n = backend::rows(A);
+
+            if (backend::nonzeros(A) != e.nnz) return false;
+
+            const bool check_drift = max_drift > 0 && !e.strength.empty();
+
+            std::vector<V> dinv;
+            if (check_drift) dinv = inverse_diagonal(A);
+
+            boost::uint64_t h = 0;
+            double num = 0, den = 0;
+
+#pragma omp parallel for reduction(+:h,num,den)
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(ptrdiff_t j = A.ptr[i], end = A.ptr[i+1]; j < end; ++j) {
+                    ptrdiff_t c = A.col[j];
+
+                    h += hash(i, c);
+
+                    if (!check_drift || c == i) continue;
+
+                    V v = A.val[j];
+                    V s = v * v * dinv[i] * dinv[c];
+
+                    num += std::abs(s - e.strength[j]);
+                    den += e.strength[j];
+                }
+            }
+
+            return h == e.pattern && (den == 0 || num <= max_drift * den);
+        }
+};
+
+namespace detail {
+
+// Discards the cached aggregates when the outer solver convergence has
+// deteriorated.
+template <template <class> class Coarsening, class Base>
+struct solver_feedback< Coarsening< cached_aggregates<Base> > > {
+    static void apply(
+            const typename Coarsening< cached_aggregates<Base> >::params &prm,
+            size_t iters)
+    {
+        typename cached_aggregates<Base>::cache *c = prm.aggr.store.get();
+
+        if (!c || prm.aggr.max_iter_growth <= 0) return;
+
+        if (c->base_iters == 0)
+            c->base_iters = iters;
+        else if (iters > prm.aggr.max_iter_growth * c->base_iters)
+            c->clear();
+    }
+};
+
+} // namespace detail
+
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
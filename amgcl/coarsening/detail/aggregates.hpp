@@ -0,0 +1,182 @@
+#ifndef AMGCL_COARSENING_DETAIL_AGGREGATES_HPP
+#define AMGCL_COARSENING_DETAIL_AGGREGATES_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/detail/aggregates.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Helpers for aggregation-based coarsenings.
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <boost/range/numeric.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+
+namespace amgcl {
+namespace coarsening {
+namespace detail {
+
+/// Galerkin operator for the piecewise-constant prolongation.
+/**
+ * Returns \f$P^T A P\f$, where \f$P\f$ is the piecewise-constant
+ * prolongation defined by the aggregates. Variables with negative aggregate
+ * ids are skipped.
+ */
+template <class Matrix>
+backend::crs<typename backend::value_type<Matrix>::type, ptrdiff_t, ptrdiff_t>
+aggregated_matrix(const Matrix &A, const std::vector<ptrdiff_t> &id, size_t count)
+{
+    typedef typename backend::value_type<Matrix>::type V;
+
+    const ptrdiff_t n  = backend::rows(A);
+    const ptrdiff_t nc = count;
+
+    // Fine variables sorted by aggregate.
+    std::vector<ptrdiff_t> aptr(nc + 1, 0);
+    for(ptrdiff_t i = 0; i < n; ++i)
+        if (id[i] >= 0) ++aptr[id[i] + 1];
+
+    boost::partial_sum(aptr, aptr.begin());
+
+    std::vector<ptrdiff_t> order(aptr.back());
+    for(ptrdiff_t i = 0; i < n; ++i)
+        if (id[i] >= 0) order[aptr[id[i]]++] = i;
+
+    std::rotate(aptr.begin(), aptr.end() - 1, aptr.end());
+    aptr.front() = 0;
+
+    backend::crs<V, ptrdiff_t, ptrdiff_t> Ac;
+    Ac.nrows = Ac.ncols = nc;
+    Ac.ptr.resize(nc + 1, 0);
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(nc, -1);
+
+#pragma omp for
+        for(ptrdiff_t ic = 0; ic < nc; ++ic) {
+            for(ptrdiff_t k = aptr[ic]; k < aptr[ic+1]; ++k) {
+                ptrdiff_t i = order[k];
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = id[A.col[j]];
+                    if (c >= 0 && marker[c] != ic) {
+                        marker[c] = ic;
+                        ++Ac.ptr[ic + 1];
+                    }
+                }
+            }
+        }
+    }
+
+    boost::partial_sum(Ac.ptr, Ac.ptr.begin());
+    Ac.col.resize(Ac.ptr.back());
+    Ac.val.resize(Ac.ptr.back());
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(nc, -1);
+
+#pragma omp for
+        for(ptrdiff_t ic = 0; ic < nc; ++ic) {
+            ptrdiff_t row_beg = Ac.ptr[ic];
+            ptrdiff_t row_end = row_beg;
+
+            for(ptrdiff_t k = aptr[ic]; k < aptr[ic+1]; ++k) {
+                ptrdiff_t i = order[k];
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = id[A.col[j]];
+                    if (c < 0) continue;
+
+                    if (marker[c] < row_beg) {
+                        marker[c] = row_end;
+                        Ac.col[row_end] = c;
+                        Ac.val[row_end] = A.val[j];
+                        ++row_end;
+                    } else {
+                        Ac.val[marker[c]] += A.val[j];
+                    }
+                }
+            }
+        }
+    }
+
+    return Ac;
+}
+
+/// Updates aggregation parameters for the next coarser level.
+/**
+ * Aggregates that keep level-dependent data in their parameters (such as the
+ * coordinates of the variables) specialize this to restrict the data to the
+ * coarse variables.
+ */
+template <class Aggregates>
+struct coarse_aggregates_params {
+    static void apply(typename Aggregates::params&, const Aggregates&) {}
+};
+
+/// Merges the aggregates into larger ones (aggregates of aggregates).
+/**
+ * The aggregates are subjected to the same aggregation scheme, applied to
+ * the Galerkin operator of the piecewise-constant prolongation. Aggregates
+ * that are left out by the second pass keep a coarse variable of their own.
+ * The strong connectivity of the system matrix is left intact.
+ */
+template <class Aggregates, class Matrix>
+void aggregate_aggregates(
+        const Matrix &A, const typename Aggregates::params &prm, Aggregates &aggr)
+{
+    const ptrdiff_t n = backend::rows(A);
+
+    typename Aggregates::params cprm = prm;
+    coarse_aggregates_params<Aggregates>::apply(cprm, aggr);
+
+    Aggregates cagg(aggregated_matrix(A, aggr.id, aggr.count), cprm);
+
+    // Left out aggregates are numbered in order, so that block structure of
+    // the ids (if any) is preserved.
+    std::vector<ptrdiff_t> &cid = cagg.id;
+    size_t count = cagg.count;
+
+    for(size_t i = 0; i < aggr.count; ++i)
+        if (cid[i] < 0) cid[i] = count++;
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i)
+        if (aggr.id[i] >= 0) aggr.id[i] = cid[aggr.id[i]];
+
+    aggr.count = count;
+}
+
+} // namespace detail
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
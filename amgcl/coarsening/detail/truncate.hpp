@@ -0,0 +1,215 @@
+#ifndef AMGCL_COARSENING_DETAIL_TRUNCATE_HPP
+#define AMGCL_COARSENING_DETAIL_TRUNCATE_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/detail/truncate.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Truncation of transfer operators and filtering of coarse operators.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <boost/range/numeric.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace coarsening {
+namespace detail {
+
+// Orders row entries by decreasing magnitude.
+template <typename Val>
+struct abs_greater {
+    const Val *val;
+
+    abs_greater(const Val *val) : val(val) {}
+
+    bool operator()(ptrdiff_t a, ptrdiff_t b) const {
+        return std::abs(val[a]) > std::abs(val[b]);
+    }
+};
+
+/// Drops small entries from the rows of a transfer operator.
+/**
+ * Entries that are smaller (in absolute value) than the largest entry of
+ * the row by a factor of eps are dropped. When max_nnz is positive, only
+ * max_nnz largest entries of each row are kept. The remaining entries are
+ * rescaled so that the row sums remain unchanged.
+ */
+template <typename Val, typename Col, typename Ptr>
+void truncate(backend::crs<Val, Col, Ptr> &P, float eps, unsigned max_nnz)
+{
+    const ptrdiff_t n = backend::rows(P);
+    const Val tiny = amgcl::detail::eps<Val>(1);
+
+    std::vector<char> keep(P.ptr.back(), 1);
+    std::vector<Ptr>  ptr(n + 1, 0);
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> idx;
+
+#pragma omp for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            Ptr beg = P.ptr[i];
+            Ptr end = P.ptr[i + 1];
+
+            Val vmax = 0, sum_all = 0;
+            for(Ptr j = beg; j < end; ++j) {
+                vmax     = std::max(vmax, static_cast<Val>(std::abs(P.val[j])));
+                sum_all += P.val[j];
+            }
+
+            idx.clear();
+            for(Ptr j = beg; j < end; ++j) {
+                if (std::abs(P.val[j]) < eps * vmax)
+                    keep[j] = 0;
+                else
+                    idx.push_back(j);
+            }
+
+            if (max_nnz > 0 && idx.size() > max_nnz) {
+                std::nth_element(idx.begin(), idx.begin() + max_nnz, idx.end(),
+                        abs_greater<Val>(&P.val[0]));
+
+                for(size_t k = max_nnz; k < idx.size(); ++k) keep[idx[k]] = 0;
+                idx.resize(max_nnz);
+            }
+
+            Val sum_kept = 0;
+            for(size_t k = 0; k < idx.size(); ++k) sum_kept += P.val[idx[k]];
+
+            if (std::abs(sum_kept) > tiny) {
+                Val scale = sum_all / sum_kept;
+                for(size_t k = 0; k < idx.size(); ++k) P.val[idx[k]] *= scale;
+            }
+
+            ptr[i + 1] = idx.size();
+        }
+    }
+
+    boost::partial_sum(ptr, ptr.begin());
+
+    std::vector<Col> col(ptr.back());
+    std::vector<Val> val(ptr.back());
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        Ptr h = ptr[i];
+        for(Ptr j = P.ptr[i], e = P.ptr[i + 1]; j < e; ++j) {
+            if (!keep[j]) continue;
+            col[h] = P.col[j];
+            val[h] = P.val[j];
+            ++h;
+        }
+    }
+
+    P.ptr.swap(ptr);
+    P.col.swap(col);
+    P.val.swap(val);
+}
+
+/// Drops weak off-diagonal entries from a coarse operator.
+/**
+ * The entry \f$a_{ij}\f$ is dropped when \f$|a_{ij}| < \varepsilon
+ * \sqrt{|a_{ii} a_{jj}|}\f$. The dropped entries are lumped to the diagonal,
+ * so that the row sums of the operator remain unchanged. Rows without a
+ * diagonal entry are left intact.
+ *
+ * Since the row sums are preserved, too large values of eps may disconnect
+ * the zero-sum rows (such as the interior rows of a Laplacian) from the rest
+ * of the operator and make it singular. Values around 0.01--0.02 are safe
+ * for typical problems.
+ */
+template <typename Val, typename Col, typename Ptr>
+void filter(backend::crs<Val, Col, Ptr> &A, float eps)
+{
+    const ptrdiff_t n = backend::rows(A);
+
+    std::vector<Val>  dia = backend::diagonal(A);
+    std::vector<char> keep(A.ptr.back(), 1);
+    std::vector<Ptr>  ptr(n + 1, 0);
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        Ptr beg = A.ptr[i];
+        Ptr end = A.ptr[i + 1];
+        Ptr d   = -1;
+
+        for(Ptr j = beg; j < end; ++j)
+            if (A.col[j] == i) { d = j; break; }
+
+        if (d < 0) {
+            ptr[i + 1] = end - beg;
+            continue;
+        }
+
+        Ptr cnt = 0;
+        for(Ptr j = beg; j < end; ++j) {
+            Col c = A.col[j];
+            Val v = A.val[j];
+
+            if (c != i && std::abs(v) < eps * std::sqrt(std::abs(dia[i] * dia[c]))) {
+                keep[j] = 0;
+                A.val[d] += v;
+            } else {
+                ++cnt;
+            }
+        }
+
+        ptr[i + 1] = cnt;
+    }
+
+    boost::partial_sum(ptr, ptr.begin());
+
+    std::vector<Col> col(ptr.back());
+    std::vector<Val> val(ptr.back());
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        Ptr h = ptr[i];
+        for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+            if (!keep[j]) continue;
+            col[h] = A.col[j];
+            val[h] = A.val[j];
+            ++h;
+        }
+    }
+
+    A.ptr.swap(ptr);
+    A.col.swap(col);
+    A.val.swap(val);
+}
+
+} // namespace detail
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
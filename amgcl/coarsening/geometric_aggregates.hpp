@@ -0,0 +1,371 @@
+#ifndef AMGCL_COARSENING_GEOMETRIC_AGGREGATES_HPP
+#define AMGCL_COARSENING_GEOMETRIC_AGGREGATES_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/geometric_aggregates.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Coordinate-aware aggregation.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <boost/cstdint.hpp>
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/coarsening/plain_aggregates.hpp>
+#include <amgcl/coarsening/detail/aggregates.hpp>
+
+namespace amgcl {
+namespace coarsening {
+
+/// Coordinate-aware (geometric) aggregation.
+/**
+ * The variables are grouped into box-shaped aggregates using the
+ * coordinates of the mesh nodes. The domain is covered with a grid of boxes
+ * of params::box mesh spacings in each direction, and each aggregate is a
+ * strongly connected group of the variables within a box. The mesh spacing
+ * in each direction is estimated as the average distance between the
+ * connected variables along that direction. This gives compact aggregates
+ * and regular coarse operators on structured and semi-structured meshes.
+ *
+ * The coordinates of the coarse variables (the centroids of the
+ * aggregates) are passed to the next level, so that the whole hierarchy is
+ * aggregated geometrically. When the coordinates are not provided, do not
+ * match the matrix size, or span too many boxes to be indexed with 64 bits,
+ * plain_aggregates are used.
+ *
+ * When params::eps_semi is set, the directions where the couplings are weak
+ * are not coarsened (semi-coarsening), which makes the scheme suitable for
+ * problems with grid-aligned anisotropy.
+ *
+ * \ingroup aggregates
+ */
+struct geometric_aggregates {
+    /// Aggregation parameters.
+    struct params : plain_aggregates::params {
+        /// Number of spatial dimensions.
+        unsigned dim;
+
+        /// Coordinates of the variables.
+        /**
+         * The coordinates are stored in row-major order, dim values per
+         * variable. When set through a property tree, "coord" should
+         * contain a pointer to the data, and "rows" should contain the
+         * number of variables.
+         */
+        std::vector<double> coord;
+
+        /// Aggregate size (in mesh spacings) along each direction.
+        unsigned box;
+
+        /// Semi-coarsening threshold.
+        /**
+         * The direction \f$d\f$ is not coarsened when the total magnitude
+         * of the couplings along \f$d\f$ is less than eps_semi times the
+         * magnitude of the couplings along the strongest direction. Zero
+         * value disables semi-coarsening.
+         */
+        float eps_semi;
+
+        params() : dim(0), box(3), eps_semi(0) {}
+
+        params(const boost::property_tree::ptree &p)
+            : plain_aggregates::params(p),
+              AMGCL_PARAMS_IMPORT_VALUE(p, dim),
+              AMGCL_PARAMS_IMPORT_VALUE(p, box),
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_semi)
+        {
+            double *c = 0;
+            c = p.get("coord", c);
+
+            if (c) {
+                size_t rows = 0;
+                rows = p.get("rows", rows);
+
+                precondition(dim > 0,
+                        "Error in aggregation parameters: "
+                        "coord is set, but dim is not"
+                        );
+
+                precondition(rows > 0,
+                        "Error in aggregation parameters: "
+                        "coord is set, but rows is not"
+                        );
+
+                coord.assign(c, c + rows * dim);
+            }
+        }
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            plain_aggregates::params::get(p, path);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, dim);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, box);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_semi);
+        }
+    };
+
+    static const ptrdiff_t undefined = -1;
+    static const ptrdiff_t removed   = -2;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::count
+    size_t count;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::strong_connection
+    std::vector<char> strong_connection;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::id
+    std::vector<ptrdiff_t> id;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::plain_aggregates
+    template <class Matrix>
+    geometric_aggregates(const Matrix &A, const params &prm) : count(0)
+    {
+        typedef typename backend::value_type<Matrix>::type V;
+
+        const ptrdiff_t n   = backend::rows(A);
+        const unsigned  dim = prm.dim;
+
+        if (dim == 0 || prm.coord.size() != static_cast<size_t>(n) * dim) {
+            plain(A, prm);
+            return;
+        }
+
+        const double *x = &prm.coord[0];
+
+        strong_connection.resize( backend::nonzeros(A) );
+        id.resize(n);
+
+        /* 1. Get strong connections, remove lonely nodes */
+        V eps_squared = prm.eps_strong * prm.eps_strong;
+        std::vector<V> dia = backend::diagonal(A);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            V eps_dia_i = eps_squared * dia[i];
+            ptrdiff_t state = removed;
+
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t c = A.col[j];
+                V         v = A.val[j];
+
+                strong_connection[j] = (c != i) && (v * v > eps_dia_i * dia[c]);
+                if (strong_connection[j]) state = undefined;
+            }
+
+            id[i] = state;
+        }
+
+        /* 2. Mesh spacing and coupling strength along each direction */
+        std::vector<double> h(dim, 0.0), s(dim, 0.0), xmin(dim, 0.0), xmax(dim, 0.0);
+        std::vector<size_t> cnt(dim, 0);
+
+        for(unsigned d = 0; d < dim; ++d) {
+            xmin[d] = xmax[d] = x[d];
+            for(ptrdiff_t i = 1; i < n; ++i) {
+                xmin[d] = std::min(xmin[d], x[i * dim + d]);
+                xmax[d] = std::max(xmax[d], x[i * dim + d]);
+            }
+        }
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t c = A.col[j];
+                if (c == i) continue;
+
+                // The direction of the connection is its dominant
+                // component.
+                unsigned dir = 0;
+                double   len = 0;
+                for(unsigned d = 0; d < dim; ++d) {
+                    double l = std::abs(x[c * dim + d] - x[i * dim + d]);
+                    if (l > len) {
+                        len = l;
+                        dir = d;
+                    }
+                }
+
+                if (len == 0) continue;
+
+                h[dir] += len;
+                s[dir] += std::abs(A.val[j]);
+                ++cnt[dir];
+            }
+        }
+
+        const double smax = *std::max_element(s.begin(), s.end());
+
+        // Box size along each direction.
+        std::vector<double> H(dim);
+        for(unsigned d = 0; d < dim; ++d) {
+            if (cnt[d] == 0) {
+                H[d] = 1;
+                continue;
+            }
+
+            h[d] /= cnt[d];
+
+            if (s[d] < prm.eps_semi * smax)
+                H[d] = h[d];
+            else
+                H[d] = prm.box * h[d];
+
+            // Shift the origin by half a spacing, so that the nodes do not
+            // lie on the box boundaries.
+            xmin[d] -= 0.5 * h[d];
+        }
+
+        /* 3. Box index of each variable */
+        // Number of boxes along each direction. The box index is the
+        // mixed-radix number of the box coordinates, so the total number of
+        // boxes should fit into 64 bits.
+        std::vector<double> nbox(dim);
+        double total = 1;
+
+        for(unsigned d = 0; d < dim; ++d) {
+            nbox[d] = std::floor((xmax[d] - xmin[d]) / H[d]) + 1;
+            total *= nbox[d];
+        }
+
+        if (!(total < 1e19)) {
+            plain(A, prm);
+            return;
+        }
+
+        std::vector<boost::uint64_t> nb(dim);
+        for(unsigned d = 0; d < dim; ++d)
+            nb[d] = static_cast<boost::uint64_t>(nbox[d]);
+
+        std::vector<boost::uint64_t> key(n);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            boost::uint64_t k = 0;
+            for(unsigned d = 0; d < dim; ++d) {
+                boost::uint64_t b = static_cast<boost::uint64_t>(
+                        std::floor((x[i * dim + d] - xmin[d]) / H[d]));
+                k = k * nb[d] + b;
+            }
+            key[i] = k;
+        }
+
+        /* 4. Strongly connected components within each box */
+        std::vector<ptrdiff_t> queue;
+        queue.reserve(64);
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            if (id[i] != undefined) continue;
+
+            ptrdiff_t cur_id = static_cast<ptrdiff_t>(count++);
+
+            id[i] = cur_id;
+            queue.clear();
+            queue.push_back(i);
+
+            for(size_t q = 0; q < queue.size(); ++q) {
+                ptrdiff_t k = queue[q];
+
+                for(ptrdiff_t j = A.ptr[k], e = A.ptr[k+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+
+                    if (strong_connection[j] && id[c] == undefined && key[c] == key[i]) {
+                        id[c] = cur_id;
+                        queue.push_back(c);
+                    }
+                }
+            }
+        }
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i)
+            if (id[i] == removed) id[i] = -1;
+    }
+
+    /// Coordinates of the coarse variables.
+    /**
+     * Returns centroids of the aggregates.
+     */
+    std::vector<double> coarse_coord(const params &prm) const {
+        const ptrdiff_t n   = id.size();
+        const unsigned  dim = prm.dim;
+
+        std::vector<double> xc(count * dim, 0.0);
+        std::vector<size_t> size(count, 0);
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t a = id[i];
+            if (a < 0) continue;
+
+            for(unsigned d = 0; d < dim; ++d)
+                xc[a * dim + d] += prm.coord[i * dim + d];
+
+            ++size[a];
+        }
+
+        for(size_t a = 0; a < count; ++a)
+            for(unsigned d = 0; d < dim; ++d)
+                xc[a * dim + d] /= size[a];
+
+        return xc;
+    }
+
+    private:
+        // Falls back to the algebraic aggregation.
+        template <class Matrix>
+        void plain(const Matrix &A, const params &prm) {
+            plain_aggregates aggr(A, prm);
+
+            count = aggr.count;
+            strong_connection.swap(aggr.strong_connection);
+            id.swap(aggr.id);
+        }
+};
+
+namespace detail {
+
+template <>
+struct coarse_aggregates_params<geometric_aggregates> {
+    static void apply(geometric_aggregates::params &prm,
+            const geometric_aggregates &aggr)
+    {
+        if (prm.dim == 0 || prm.coord.size() != aggr.id.size() * prm.dim) {
+            prm.coord.clear();
+        } else {
+            std::vector<double> xc = aggr.coarse_coord(prm);
+            prm.coord.swap(xc);
+        }
+    }
+};
+
+} // namespace detail
+
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
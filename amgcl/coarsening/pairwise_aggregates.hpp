@@ -0,0 +1,246 @@
+#ifndef AMGCL_COARSENING_PAIRWISE_AGGREGATES_HPP
+#define AMGCL_COARSENING_PAIRWISE_AGGREGATES_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/pairwise_aggregates.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Pairwise aggregation.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/coarsening/detail/aggregates.hpp>
+
+namespace amgcl {
+namespace coarsening {
+
+/// Pairwise aggregation.
+/**
+ * Aggregates are formed with several passes of pairwise matching
+ * \cite Notay2010. Each pass matches every variable with its strongest
+ * unmatched negative coupling, where the coupling \f$a_{ij}\f$ is strong if
+ * \f$-a_{ij} \geq \beta \max_k(-a_{ik})\f$. Variables without strong
+ * couplings stay single. The next pass works with the Galerkin matrix of the
+ * pairs found so far, so two passes (the default) result in aggregates of
+ * about four variables, three passes in aggregates of about eight.
+ *
+ * Strongly diagonally dominant rows are excluded from aggregation, so that
+ * the corresponding variables stay at the fine level.
+ *
+ * The aggregates are intended for use with unsmoothed
+ * coarsening::aggregation. The resulting hierarchies have very low operator
+ * complexity and are cheap to set up, and work best when the AMG cycle is
+ * accelerated with a Krylov solver.
+ *
+ * \ingroup aggregates
+ */
+struct pairwise_aggregates {
+    /// Aggregation parameters.
+    struct params {
+        /// Parameter \f$\beta\f$ defining strong couplings.
+        /**
+         * The coupling \f$a_{ij}\f$ is strong if \f$-a_{ij} \geq \beta
+         * \max_k(-a_{ik})\f$. The name of the parameter is shared with
+         * plain_aggregates, so that the coarsenings that relax the strength
+         * threshold (e.g. smoothed_aggregation) work with these aggregates.
+         */
+        float eps_strong;
+
+        /// Number of pairwise matching passes.
+        unsigned passes;
+
+        /// Diagonal dominance threshold \f$\kappa\f$.
+        /**
+         * Rows with \f$a_{ii} \geq \frac{\kappa}{\kappa - 2} \sum_{j \neq
+         * i} |a_{ij}|\f$ are excluded from aggregation. Should be greater
+         * than 2. Larger values exclude fewer rows.
+         */
+        float kappa;
+
+        params() : eps_strong(0.25f), passes(2), kappa(10.0f) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
+              AMGCL_PARAMS_IMPORT_VALUE(p, passes),
+              AMGCL_PARAMS_IMPORT_VALUE(p, kappa)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, passes);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, kappa);
+        }
+    };
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::count
+    size_t count;
+
+    /// Strong connectivity matrix.
+    /**
+     * Marks the couplings of the system matrix that are strong according to
+     * the criterion used in the first matching pass. This is just 'values'
+     * part of CRS matrix. 'col' and 'ptr' arrays are borrowed from the
+     * system matrix.
+     */
+    std::vector<char> strong_connection;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::id
+    std::vector<ptrdiff_t> id;
+
+    /// \copydoc amgcl::coarsening::plain_aggregates::plain_aggregates
+    template <class Matrix>
+    pairwise_aggregates(const Matrix &A, const params &prm)
+        : count(0),
+          strong_connection( backend::nonzeros(A) ),
+          id( backend::rows(A) )
+    {
+        typedef typename backend::value_type<Matrix>::type V;
+        typedef backend::crs<V, ptrdiff_t, ptrdiff_t>       matrix;
+
+        const ptrdiff_t n = backend::rows(A);
+
+        precondition(prm.kappa > 2,
+                "Error in aggregation parameters: "
+                "kappa should be greater than 2"
+                );
+
+        // Strong couplings and diagonally dominant rows of the system matrix.
+        const V dd = prm.kappa / (prm.kappa - 2);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            V dia = 0, off = 0, amax = 0;
+
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                if (A.col[j] == i) {
+                    dia += A.val[j];
+                } else {
+                    off += std::abs(A.val[j]);
+                    amax = std::max(amax, -A.val[j]);
+                }
+            }
+
+            V thr = prm.eps_strong * amax;
+
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                strong_connection[j] = A.col[j] != i && amax > 0 && -A.val[j] >= thr;
+
+            if (dia >= dd * off)
+                id[i] = removed;
+            else
+                id[i] = undefined;
+        }
+
+        count = match(A, strong_connection, id);
+
+        // Further passes match the pairs found so far.
+        std::vector<ptrdiff_t> cid;
+        std::vector<char>      cs;
+
+        for(unsigned pass = 1; pass < prm.passes; ++pass) {
+            matrix Ac = detail::aggregated_matrix(A, id, count);
+
+            const ptrdiff_t nc = Ac.nrows;
+
+            cs.resize(Ac.ptr.back());
+            cid.resize(nc);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < nc; ++i) {
+                V amax = 0;
+
+                for(ptrdiff_t j = Ac.ptr[i], e = Ac.ptr[i+1]; j < e; ++j)
+                    if (Ac.col[j] != i) amax = std::max(amax, -Ac.val[j]);
+
+                V thr = prm.eps_strong * amax;
+
+                for(ptrdiff_t j = Ac.ptr[i], e = Ac.ptr[i+1]; j < e; ++j)
+                    cs[j] = Ac.col[j] != i && amax > 0 && -Ac.val[j] >= thr;
+
+                cid[i] = undefined;
+            }
+
+            count = match(Ac, cs, cid);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (id[i] >= 0) id[i] = cid[id[i]];
+        }
+    }
+
+    private:
+        static const ptrdiff_t undefined = -1;
+        static const ptrdiff_t removed   = -2;
+
+        // Matches each undefined variable with its strongest unmatched
+        // neighbour. Returns the number of pairs (and singletons); removed
+        // variables are marked with -1.
+        template <class Matrix>
+        static size_t match(const Matrix &A, const std::vector<char> &S,
+                std::vector<ptrdiff_t> &id)
+        {
+            const ptrdiff_t n = backend::rows(A);
+            size_t cnt = 0;
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (id[i] != undefined) continue;
+
+                ptrdiff_t cur = static_cast<ptrdiff_t>(cnt++);
+                ptrdiff_t pair = -1;
+                typename backend::value_type<Matrix>::type amin = 0;
+
+                id[i] = cur;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    if (!S[j] || id[c] != undefined) continue;
+
+                    if (pair < 0 || A.val[j] < amin) {
+                        pair = c;
+                        amin = A.val[j];
+                    }
+                }
+
+                if (pair >= 0) id[pair] = cur;
+            }
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (id[i] == removed) id[i] = -1;
+
+            return cnt;
+        }
+};
+
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 #include <vector>
 #include <boost/foreach.hpp>
+#include <boost/cstdint.hpp>
 #include <amgcl/util.hpp>
 #include <amgcl/backend/builtin.hpp>
 
@@ -57,6 +58,14 @@ namespace coarsening {
  * beloning to this aggregate. Later they may be claimed by other aggregates;
  * if nobody claims them, then they just stay in their initial aggregate.
  *
+ * When params::parallel is set, the aggregation is done in parallel instead.
+ * The aggregate roots form a distance-2 maximal independent set of the
+ * strong connectivity graph, which is found with a Luby-type algorithm
+ * \cite Bell2012. The vertex priorities are pseudo-random, but only depend
+ * on the vertex number, so the aggregates do not depend on the number of
+ * threads. The rest of the vertices are attached to a neighbouring
+ * aggregate in two parallel sweeps.
+ *
  * \ingroup aggregates
  */
 struct plain_aggregates {
@@ -71,14 +80,19 @@ struct plain_aggregates {
          */
         float eps_strong;
 
-        params() : eps_strong(0.0f) {}
+        /// Use parallel aggregation based on distance-2 independent sets.
+        bool parallel;
+
+        params() : eps_strong(0.0f), parallel(false) {}
 
         params(const boost::property_tree::ptree &p)
-            : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
+              AMGCL_PARAMS_IMPORT_VALUE(p, parallel)
         {}
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, parallel);
         }
     };
 
@@ -131,6 +145,10 @@ struct plain_aggregates {
         }
 
         /* 2. Get aggregate ids */
+        if (prm.parallel) {
+            parallel_aggregation(A);
+            return;
+        }
 
         // Remove lonely nodes.
         size_t max_neib = 0;
@@ -182,6 +200,139 @@ struct plain_aggregates {
             }
         }
     }
+
+    private:
+        // Vertex states for the independent set search.
+        enum { mis_out = 0, mis_undecided = 1, mis_root = 2 };
+
+        // Priority of a vertex: the state comes first, then the random weight.
+        // The ties are broken by the vertex number.
+        static boost::uint64_t mis_key(int state, unsigned weight) {
+            return (static_cast<boost::uint64_t>(state) << 32) | weight;
+        }
+
+        static bool mis_less(const std::vector<boost::uint64_t> &key, ptrdiff_t a, ptrdiff_t b) {
+            return key[a] < key[b] || (key[a] == key[b] && a < b);
+        }
+
+        template <class Matrix>
+        void parallel_aggregation(const Matrix &A) {
+            const ptrdiff_t n = rows(A);
+
+            // Remove lonely nodes.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t state = removed;
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    if (strong_connection[j]) {
+                        state = undefined;
+                        break;
+                    }
+
+                id[i] = state;
+            }
+
+            // Distance-2 maximal independent set. Each round every vertex
+            // finds the highest priority vertex in its distance-2
+            // neighbourhood. Undecided vertices that are the maxima become
+            // roots; those with a root in their neighbourhood are out.
+            std::vector<unsigned>        weight(n);
+            std::vector<boost::uint64_t> key(n);
+            std::vector<ptrdiff_t>       max1(n), max2(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                weight[i] = amgcl::detail::random_weight(i);
+                key[i]    = mis_key(id[i] == removed ? mis_out : mis_undecided, weight[i]);
+            }
+
+            for(ptrdiff_t left = n; left > 0; ) {
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    ptrdiff_t m = i;
+
+                    for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                        ptrdiff_t c = A.col[j];
+                        if (strong_connection[j] && mis_less(key, m, c)) m = c;
+                    }
+
+                    max1[i] = m;
+                }
+
+                // Only the undecided vertices need the second hop.
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    if (key[i] >> 32 != mis_undecided) continue;
+
+                    ptrdiff_t m = max1[i];
+
+                    for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                        ptrdiff_t c = max1[A.col[j]];
+                        if (strong_connection[j] && mis_less(key, m, c)) m = c;
+                    }
+
+                    max2[i] = m;
+                }
+
+                left = 0;
+
+#pragma omp parallel for reduction(+:left)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    if (key[i] >> 32 != mis_undecided) continue;
+
+                    if (max2[i] == i)
+                        max1[i] = mis_root;
+                    else if (key[max2[i]] >> 32 == mis_root)
+                        max1[i] = mis_out;
+                    else
+                        max1[i] = mis_undecided;
+
+                    if (max1[i] == mis_undecided) ++left;
+                }
+
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    if (key[i] >> 32 == mis_undecided)
+                        key[i] = mis_key(max1[i], weight[i]);
+            }
+
+            // Number the aggregates in the order of their roots.
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (key[i] >> 32 == mis_root) id[i] = static_cast<ptrdiff_t>(count++);
+
+            // Attach the remaining vertices: first the neighbours of the
+            // roots, then their neighbours. The aggregate of the
+            // highest priority neighbour is taken.
+            std::vector<ptrdiff_t> new_id(n);
+
+            for(int pass = 0; pass < 2; ++pass) {
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    new_id[i] = id[i];
+
+                    if (id[i] != undefined) continue;
+
+                    ptrdiff_t m = -1;
+                    for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                        if (!strong_connection[j]) continue;
+
+                        ptrdiff_t c = A.col[j];
+                        if (id[c] < 0) continue;
+
+                        if (m < 0 || mis_less(key, m, c)) m = c;
+                    }
+
+                    if (m >= 0) new_id[i] = id[m];
+                }
+
+                id.swap(new_id);
+            }
+
+            // Just in case the connectivity is not symmetric: the vertices
+            // that are still not aggregated form their own aggregates.
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (id[i] == undefined) id[i] = static_cast<ptrdiff_t>(count++);
+        }
 };
 
 } // namespace coarsening
@@ -40,6 +40,7 @@ THE SOFTWARE.
 #include <amgcl/util.hpp>
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/plain_aggregates.hpp>
+#include <amgcl/coarsening/detail/aggregates.hpp>
 
 namespace amgcl {
 namespace coarsening {
@@ -49,6 +50,14 @@ namespace coarsening {
  * The system matrix should have block structure. It is reduced to a single
  * value per block and is subjected to coarsening::plain_aggregation.
  *
+ * The blocks may have variable size, when the mesh nodes carry different
+ * number of unknowns. In this case the unknowns of each node should be
+ * numbered contiguously, and params::node_ptr should describe the
+ * partitioning. Unknown \f$k\f$ of each node in an aggregate is assigned to
+ * coarse variable \f$k\f$ of the aggregate, so the aggregate gets as many
+ * coarse variables as its largest node has unknowns. The node structure of
+ * the coarse level is passed to the next level.
+ *
  * \ingroup aggregates
  */
 class pointwise_aggregates {
@@ -62,12 +71,37 @@ class pointwise_aggregates {
              */
             unsigned block_size;
 
+            /// Node pointers for variable block size.
+            /**
+             * Unknowns of node \f$k\f$ are \f$node\_ptr_k \le i <
+             * node\_ptr_{k+1}\f$. When set, block_size is ignored. When set
+             * through a property tree, "node_ptr" should contain a pointer to
+             * an array of integers, and "nodes" should contain the number of
+             * nodes.
+             */
+            std::vector<ptrdiff_t> node_ptr;
+
             params() : block_size(1) {}
 
             params(const boost::property_tree::ptree &p)
                 : plain_aggregates::params(p),
                   AMGCL_PARAMS_IMPORT_VALUE(p, block_size)
-            {}
+            {
+                int *np = 0;
+                np = p.get("node_ptr", np);
+
+                if (np) {
+                    size_t nodes = 0;
+                    nodes = p.get("nodes", nodes);
+
+                    precondition(nodes > 0,
+                            "Error in aggregation parameters: "
+                            "node_ptr is set, but nodes is not"
+                            );
+
+                    node_ptr.assign(np, np + nodes + 1);
+                }
+            }
 
             void get(boost::property_tree::ptree &p, const std::string &path) const {
                 plain_aggregates::params::get(p, path);
@@ -91,7 +125,11 @@ class pointwise_aggregates {
         template <class Matrix>
         pointwise_aggregates(const Matrix &A, const params &prm) : count(0)
         {
-            if (prm.block_size == 1) {
+            if (!prm.node_ptr.empty()
+                    && static_cast<size_t>(prm.node_ptr.back()) == rows(A))
+            {
+                variable_block_aggregates(A, prm);
+            } else if (prm.block_size == 1) {
                 plain_aggregates aggr(A, prm);
 
                 count = aggr.count;
@@ -146,6 +184,194 @@ class pointwise_aggregates {
             }
         }
 
+        /// Returns node pointers for the coarse level.
+        /**
+         * The coarse unknowns of an aggregate form a coarse node. The
+         * starting unknown of each coarse node is the one that receives
+         * the first unknown of a fine node.
+         */
+        std::vector<ptrdiff_t> coarse_node_ptr(const params &prm) const {
+            const ptrdiff_t np = prm.node_ptr.size() - 1;
+
+            std::vector<char> start(count + 1, 0);
+            start[count] = 1;
+
+            for(ptrdiff_t ip = 0; ip < np; ++ip) {
+                if (prm.node_ptr[ip] == prm.node_ptr[ip + 1]) continue;
+
+                ptrdiff_t c = id[prm.node_ptr[ip]];
+                if (c >= 0) start[c] = 1;
+            }
+
+            std::vector<ptrdiff_t> cptr;
+            cptr.reserve(count + 1);
+
+            for(size_t i = 0; i <= count; ++i)
+                if (start[i]) cptr.push_back(i);
+
+            return cptr;
+        }
+
+    private:
+        template <class Matrix>
+        void variable_block_aggregates(const Matrix &A, const params &prm) {
+            const std::vector<ptrdiff_t> &nptr = prm.node_ptr;
+
+            const ptrdiff_t n  = rows(A);
+            const ptrdiff_t np = nptr.size() - 1;
+
+            strong_connection.resize( nonzeros(A) );
+            id.resize(n);
+
+            // Node of each unknown.
+            std::vector<ptrdiff_t> node(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t ip = 0; ip < np; ++ip)
+                for(ptrdiff_t i = nptr[ip]; i < nptr[ip + 1]; ++i)
+                    node[i] = ip;
+
+            backend::crs<typename backend::value_type<Matrix>::type> Ap =
+                pointwise_matrix(A, nptr, node);
+
+            plain_aggregates pw_aggr(Ap, prm);
+
+            // Each aggregate gets as many coarse unknowns as its largest
+            // node has.
+            std::vector<ptrdiff_t> aptr(pw_aggr.count + 1, 0);
+            for(ptrdiff_t ip = 0; ip < np; ++ip) {
+                ptrdiff_t a = pw_aggr.id[ip];
+                if (a >= 0)
+                    aptr[a + 1] = std::max(aptr[a + 1], nptr[ip + 1] - nptr[ip]);
+            }
+
+            boost::partial_sum(aptr, aptr.begin());
+            count = aptr.back();
+
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(np, -1);
+
+#ifdef _OPENMP
+                int nt  = omp_get_num_threads();
+                int tid = omp_get_thread_num();
+
+                ptrdiff_t chunk_size  = (np + nt - 1) / nt;
+                ptrdiff_t chunk_start = tid * chunk_size;
+                ptrdiff_t chunk_end   = std::min(np, chunk_start + chunk_size);
+#else
+                ptrdiff_t chunk_start = 0;
+                ptrdiff_t chunk_end   = np;
+#endif
+
+                for(ptrdiff_t ip = chunk_start; ip < chunk_end; ++ip) {
+                    ptrdiff_t row_beg = Ap.ptr[ip];
+                    ptrdiff_t row_end = row_beg;
+                    ptrdiff_t a       = pw_aggr.id[ip];
+
+                    for(ptrdiff_t ia = nptr[ip], k = 0; ia < nptr[ip + 1]; ++ia, ++k) {
+                        id[ia] = a < 0 ? a : aptr[a] + k;
+
+                        for(ptrdiff_t ja = A.ptr[ia], ea = A.ptr[ia+1]; ja < ea; ++ja) {
+                            ptrdiff_t cp = node[A.col[ja]];
+
+                            if (marker[cp] < row_beg) {
+                                marker[cp] = row_end;
+                                strong_connection[ja] = pw_aggr.strong_connection[row_end];
+                                ++row_end;
+                            } else {
+                                strong_connection[ja] = pw_aggr.strong_connection[ marker[cp] ];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Reduces the matrix with variable block size to a single value per
+        // block.
+        template <class Matrix>
+        static backend::crs<typename backend::value_type<Matrix>::type>
+        pointwise_matrix(const Matrix &A,
+                const std::vector<ptrdiff_t> &nptr,
+                const std::vector<ptrdiff_t> &node)
+        {
+            typedef typename backend::value_type<Matrix>::type   V;
+            typedef typename backend::row_iterator<Matrix>::type row_iterator;
+
+            const ptrdiff_t np = nptr.size() - 1;
+
+            backend::crs<V> Ap;
+            Ap.nrows = np;
+            Ap.ncols = np;
+            Ap.ptr.resize(np + 1, 0);
+
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(np, -1);
+
+#ifdef _OPENMP
+                int nt  = omp_get_num_threads();
+                int tid = omp_get_thread_num();
+
+                ptrdiff_t chunk_size  = (np + nt - 1) / nt;
+                ptrdiff_t chunk_start = tid * chunk_size;
+                ptrdiff_t chunk_end   = std::min(np, chunk_start + chunk_size);
+#else
+                ptrdiff_t chunk_start = 0;
+                ptrdiff_t chunk_end   = np;
+#endif
+
+                // Count number of nonzeros in block matrix.
+                for(ptrdiff_t ip = chunk_start; ip < chunk_end; ++ip) {
+                    for(ptrdiff_t ia = nptr[ip]; ia < nptr[ip + 1]; ++ia) {
+                        for(row_iterator a = backend::row_begin(A, ia); a; ++a) {
+                            ptrdiff_t cp = node[a.col()];
+                            if (marker[cp] != ip) {
+                                marker[cp] = ip;
+                                ++Ap.ptr[ip + 1];
+                            }
+                        }
+                    }
+                }
+
+                boost::fill(marker, -1);
+
+#pragma omp barrier
+#pragma omp single
+                {
+                    boost::partial_sum(Ap.ptr, Ap.ptr.begin());
+                    Ap.col.resize(Ap.ptr.back());
+                    Ap.val.resize(Ap.ptr.back());
+                }
+
+                // Fill the reduced matrix. Use max norm for blocks.
+                for(ptrdiff_t ip = chunk_start; ip < chunk_end; ++ip) {
+                    ptrdiff_t row_beg = Ap.ptr[ip];
+                    ptrdiff_t row_end = row_beg;
+
+                    for(ptrdiff_t ia = nptr[ip]; ia < nptr[ip + 1]; ++ia) {
+                        for(row_iterator a = backend::row_begin(A, ia); a; ++a) {
+                            ptrdiff_t cp = node[a.col()];
+                            V         va = fabs(a.value());
+
+                            if (marker[cp] < row_beg) {
+                                marker[cp] = row_end;
+                                Ap.col[row_end] = cp;
+                                Ap.val[row_end] = va;
+                                ++row_end;
+                            } else {
+                                Ap.val[marker[cp]] = std::max(Ap.val[marker[cp]], va);
+                            }
+                        }
+                    }
+                }
+            }
+
+            return Ap;
+        }
+
+    public:
         template <class Matrix>
         static backend::crs<typename backend::value_type<Matrix>::type>
         pointwise_matrix(const Matrix &A, size_t block_size) {
@@ -231,6 +457,26 @@ class pointwise_aggregates {
         }
 };
 
+namespace detail {
+
+template <>
+struct coarse_aggregates_params<pointwise_aggregates> {
+    static void apply(pointwise_aggregates::params &prm,
+            const pointwise_aggregates &aggr)
+    {
+        if (prm.node_ptr.empty()) return;
+
+        if (static_cast<size_t>(prm.node_ptr.back()) != aggr.id.size()) {
+            prm.node_ptr.clear();
+        } else {
+            std::vector<ptrdiff_t> cptr = aggr.coarse_node_ptr(prm);
+            prm.node_ptr.swap(cptr);
+        }
+    }
+};
+
+} // namespace detail
+
 } // namespace coarsening
 } // namespace amgcl
 
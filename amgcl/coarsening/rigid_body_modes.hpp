@@ -0,0 +1,144 @@
+#ifndef AMGCL_COARSENING_RIGID_BODY_MODES_HPP
+#define AMGCL_COARSENING_RIGID_BODY_MODES_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/rigid_body_modes.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Rigid body modes for elasticity problems.
+ */
+
+#include <vector>
+
+#include <boost/range.hpp>
+
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace coarsening {
+
+/// Builds rigid body modes from the coordinates of the mesh nodes.
+/**
+ * The modes (3 in 2D, 6 in 3D) are returned in the format expected by
+ * nullspace_params: as columns of a row-major matrix with one row per
+ * degree of freedom. The degrees of freedom are assumed to be interleaved,
+ * that is, the unknowns of node \f$i\f$ are \f$i \cdot ndim + d\f$ for
+ * \f$d < ndim\f$. The coordinates are centered, but the modes are not
+ * orthonormalized, since tentative_prolongation() orthonormalizes them
+ * within each aggregate anyway.
+ *
+ * The modes already couple the components of the displacement, so they
+ * should be used with scalar aggregation (block_size = 1 for
+ * pointwise_aggregates). Splitting the components into separate aggregates
+ * would make the local modes linearly dependent.
+ *
+ * \param ndim Number of spatial dimensions (2 or 3).
+ * \param coo  Node coordinates (ndim values per node).
+ * \param B    Output near nullspace vectors.
+ * \returns    Number of the modes.
+ *
+ * Example:
+ * \code
+ * prm.coarsening.nullspace.cols = amgcl::coarsening::rigid_body_modes(
+ *         3, coo, prm.coarsening.nullspace.B);
+ * \endcode
+ */
+template <class Vector>
+int rigid_body_modes(int ndim, const Vector &coo, std::vector<double> &B) {
+    precondition(ndim == 2 || ndim == 3,
+            "Only 2D or 3D problems are supported");
+
+    precondition(boost::size(coo) % ndim == 0,
+            "Coordinate vector size should be divisible by ndim");
+
+    typedef typename boost::range_iterator<const Vector>::type iterator;
+
+    const ptrdiff_t n      = boost::size(coo) / ndim;
+    const int       nmodes = (ndim == 2 ? 3 : 6);
+
+    iterator x = boost::begin(coo);
+
+    // Center the coordinates to improve the conditioning of the modes.
+    double x0 = 0, y0 = 0, z0 = 0;
+
+#pragma omp parallel for reduction(+:x0,y0,z0)
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        x0 += x[i * ndim + 0];
+        y0 += x[i * ndim + 1];
+        if (ndim == 3) z0 += x[i * ndim + 2];
+    }
+
+    if (n > 0) {
+        x0 /= n;
+        y0 /= n;
+        z0 /= n;
+    }
+
+    B.resize(n * ndim * nmodes);
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        double *b = &B[i * ndim * nmodes];
+        for(int j = 0; j < ndim * nmodes; ++j) b[j] = 0;
+
+        double px = x[i * ndim + 0] - x0;
+        double py = x[i * ndim + 1] - y0;
+
+        if (ndim == 2) {
+            // Translations.
+            b[0 * nmodes + 0] = 1;
+            b[1 * nmodes + 1] = 1;
+
+            // Rotation.
+            b[0 * nmodes + 2] = -py;
+            b[1 * nmodes + 2] =  px;
+        } else {
+            double pz = x[i * ndim + 2] - z0;
+
+            // Translations.
+            b[0 * nmodes + 0] = 1;
+            b[1 * nmodes + 1] = 1;
+            b[2 * nmodes + 2] = 1;
+
+            // Rotations around z, x, and y axes.
+            b[0 * nmodes + 3] =  py;
+            b[1 * nmodes + 3] = -px;
+
+            b[1 * nmodes + 4] = -pz;
+            b[2 * nmodes + 4] =  py;
+
+            b[0 * nmodes + 5] =  pz;
+            b[2 * nmodes + 5] = -px;
+        }
+    }
+
+    return nmodes;
+}
+
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
@@ -31,6 +31,11 @@ THE SOFTWARE.
  * \brief  Ruge-Stuben coarsening with direct interpolation.
  */
 
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
 #include <boost/foreach.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/shared_ptr.hpp>
@@ -38,13 +43,90 @@ THE SOFTWARE.
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/detail/scaled_galerkin.hpp>
+#include <amgcl/detail/sort_row.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
 namespace coarsening {
 
+/// C/F splitting algorithms for amgcl::coarsening::ruge_stuben.
+namespace cf_splitting {
+enum type {
+    classic,    ///< Classic sequential Ruge-Stuben splitting.
+    pmis,       ///< Parallel modified independent set.
+    hmis        ///< Classic splitting of row blocks followed by PMIS.
+};
+
+inline std::ostream& operator<<(std::ostream &os, type s) {
+    switch (s) {
+        case classic:
+            return os << "classic";
+        case pmis:
+            return os << "pmis";
+        case hmis:
+            return os << "hmis";
+        default:
+            return os << "???";
+    }
+}
+
+inline std::istream& operator>>(std::istream &in, type &s) {
+    std::string val;
+    in >> val;
+
+    if (val == "classic")
+        s = classic;
+    else if (val == "pmis")
+        s = pmis;
+    else if (val == "hmis")
+        s = hmis;
+    else
+        throw std::invalid_argument("Invalid C/F splitting value");
+
+    return in;
+}
+} // namespace cf_splitting
+
+/// Interpolation schemes for amgcl::coarsening::ruge_stuben.
+namespace interpolation {
+enum type {
+    direct,     ///< Direct interpolation.
+    extended_i  ///< Distance-two extended+i interpolation.
+};
+
+inline std::ostream& operator<<(std::ostream &os, type s) {
+    switch (s) {
+        case direct:
+            return os << "direct";
+        case extended_i:
+            return os << "extended_i";
+        default:
+            return os << "???";
+    }
+}
+
+inline std::istream& operator>>(std::istream &in, type &s) {
+    std::string val;
+    in >> val;
+
+    if (val == "direct")
+        s = direct;
+    else if (val == "extended_i")
+        s = extended_i;
+    else
+        throw std::invalid_argument("Invalid interpolation value");
+
+    return in;
+}
+} // namespace interpolation
+
 /// Classic Ruge-Stuben coarsening with direct interpolation.
 /**
+ * The classic C/F splitting is sequential. The parallel PMIS and HMIS
+ * splittings \cite DeSterck2006 produce sparser coarse levels, and should be
+ * combined with the distance-two extended+i interpolation
+ * \cite DeSterck2008 to keep the convergence rate.
+ *
  * \ingroup coarsening
  * \sa \cite Stuben1999
  */
@@ -76,36 +158,85 @@ struct ruge_stuben {
         /// Truncation parameter \f$\varepsilon_{tr}\f$.
         float eps_trunc;
 
-        params() : eps_strong(0.25f), do_trunc(true), eps_trunc(0.2f) {}
+        /// C/F splitting algorithm.
+        cf_splitting::type split;
+
+        /// Interpolation scheme.
+        /**
+         * With extended+i interpolation, truncation drops the weights that
+         * are smaller than the largest one in the row by a factor of
+         * \f$\varepsilon_{tr}\f$.
+         */
+        interpolation::type interp;
+
+        /// Number of the first levels that use aggressive coarsening.
+        /**
+         * On these levels the C points of the C/F splitting are split once
+         * more, this time considering two C points strongly connected when
+         * there is a path of length at most two between them in the strong
+         * connectivity graph. The prolongation operator is then built with
+         * multipass interpolation \cite Stuben1999. This greatly reduces the
+         * size of the coarse levels at the cost of weaker convergence.
+         *
+         * The value is decremented each time an aggressive level is built.
+         */
+        unsigned aggressive_levels;
+
+        params()
+            : eps_strong(0.25f), do_trunc(true), eps_trunc(0.2f),
+              split(cf_splitting::classic), interp(interpolation::direct),
+              aggressive_levels(0)
+        {}
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
               AMGCL_PARAMS_IMPORT_VALUE(p, do_trunc),
-              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc)
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, split),
+              AMGCL_PARAMS_IMPORT_VALUE(p, interp),
+              AMGCL_PARAMS_IMPORT_VALUE(p, aggressive_levels)
         {}
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, do_trunc);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_trunc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, split);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, interp);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, aggressive_levels);
         }
     };
 
     /// \copydoc amgcl::coarsening::aggregation::transfer_operators
     template <class Matrix>
     static boost::tuple< boost::shared_ptr<Matrix>, boost::shared_ptr<Matrix> >
-    transfer_operators(const Matrix &A, const params &prm)
+    transfer_operators(const Matrix &A, params &prm)
     {
         typedef typename backend::value_type<Matrix>::type Val;
         const size_t n = rows(A);
         const Val eps = amgcl::detail::eps<Val>(1);
 
+        const bool aggressive = prm.aggressive_levels > 0;
+        if (aggressive) --prm.aggressive_levels;
+
         std::vector<char> cf(n, 'U');
         backend::crs<char, ptrdiff_t, ptrdiff_t> S;
 
         TIC("C/F split");
         connect(A, prm.eps_strong, S, cf);
-        cfsplit(A, S, cf);
+        switch (prm.split) {
+            case cf_splitting::classic:
+                cfsplit(A, S, cf, 0, n);
+                break;
+            case cf_splitting::pmis:
+                pmis(A, S, cf);
+                break;
+            case cf_splitting::hmis:
+                hmis(A, S, cf, hmis_block);
+                break;
+        }
+
+        if (aggressive) aggressive_split(A, S, cf);
         TOC("C/F split");
 
         TIC("interpolation");
@@ -114,6 +245,17 @@ struct ruge_stuben {
         for(size_t i = 0; i < n; ++i)
             if (cf[i] == 'C') cidx[i] = static_cast<ptrdiff_t>(nc++);
 
+        if (aggressive || prm.interp == interpolation::extended_i) {
+            boost::shared_ptr<Matrix> P = aggressive ?
+                multipass(A, S, cf, cidx, nc, prm) :
+                extended_i(A, S, cf, cidx, nc, prm);
+            TOC("interpolation");
+
+            boost::shared_ptr<Matrix> R = boost::make_shared<Matrix>();
+            *R = transpose(*P);
+            return boost::make_tuple(P, R);
+        }
+
         boost::shared_ptr<Matrix> P = boost::make_shared<Matrix>();
         P->nrows = n;
         P->ncols = nc;
@@ -248,6 +390,9 @@ struct ruge_stuben {
     }
 
     private:
+        // Number of rows in the independent blocks of the HMIS splitting.
+        static const ptrdiff_t hmis_block = 65536;
+
         //-------------------------------------------------------------------
         // On return S will hold both strong connection matrix (in S.val, which
         // is piggybacking A.ptr and A.col), and its transposition (in S.ptr
@@ -308,22 +453,30 @@ struct ruge_stuben {
         }
 
         // Split variables into C(oarse) and F(ine) sets.
+        //
+        // Only the rows in [beg, end) and the couplings between them are
+        // considered, so that independent row blocks may be split in
+        // parallel.
         template <typename Val, typename Col, typename Ptr>
         static void cfsplit(
                 backend::crs<Val,  Col, Ptr> const &A,
                 backend::crs<char, Col, Ptr> const &S,
-                std::vector<char>                  &cf
+                std::vector<char>                  &cf,
+                ptrdiff_t beg, ptrdiff_t end
                 )
         {
-            const size_t n = rows(A);
+            const ptrdiff_t n = end - beg;
 
             std::vector<Col> lambda(n);
 
             // Initialize lambdas:
-            for(size_t i = 0; i < n; ++i) {
+            for(ptrdiff_t i = 0; i < n; ++i) {
                 Col temp = 0;
-                for(Ptr j = S.ptr[i], e = S.ptr[i+1]; j < e; ++j)
-                    temp += ( cf[ S.col[j] ] == 'U' ? 1 : 2 );
+                for(Ptr j = S.ptr[beg + i], e = S.ptr[beg + i + 1]; j < e; ++j) {
+                    Col c = S.col[j];
+                    if (c < beg || c >= end) continue;
+                    temp += ( cf[c] == 'U' ? 1 : 2 );
+                }
                 lambda[i] = temp;
             }
 
@@ -337,11 +490,11 @@ struct ruge_stuben {
             std::vector<Ptr> i2n(n);
             std::vector<Ptr> n2i(n);
 
-            for(size_t i = 0; i < n; ++i) ++ptr[lambda[i] + 1];
+            for(ptrdiff_t i = 0; i < n; ++i) ++ptr[lambda[i] + 1];
 
             boost::partial_sum(ptr, ptr.begin());
 
-            for(size_t i = 0; i < n; ++i) {
+            for(ptrdiff_t i = 0; i < n; ++i) {
                 Col lam = lambda[i];
                 Ptr idx = ptr[lam] + cnt[lam]++;
                 i2n[idx] = i;
@@ -352,28 +505,28 @@ struct ruge_stuben {
             // 1. The vaiable with maximum value of lambda becomes next C-variable.
             // 2. Its neighbours from S' become F-variables.
             // 3. Keep lambda values in sync.
-            for(size_t top = n; top-- > 0; ) {
+            for(ptrdiff_t top = n; top-- > 0; ) {
                 Ptr i   = i2n[top];
                 Col lam = lambda[i];
 
                 if (lam == 0) {
-                    boost::replace(cf, 'U', 'C');
+                    std::replace(cf.begin() + beg, cf.begin() + end, 'U', 'C');
                     break;
                 }
 
                 // Remove tne variable from its group.
                 --cnt[lam];
 
-                if (cf[i] == 'F') continue;
+                if (cf[beg + i] == 'F') continue;
 
                 // Mark the variable as 'C'.
-                cf[i] = 'C';
+                cf[beg + i] = 'C';
 
                 // Its neighbours from S' become F-variables.
-                for(Ptr j = S.ptr[i], e = S.ptr[i + 1]; j < e; ++j) {
+                for(Ptr j = S.ptr[beg + i], e = S.ptr[beg + i + 1]; j < e; ++j) {
                     Col c = S.col[j];
 
-                    if (cf[c] != 'U') continue;
+                    if (c < beg || c >= end || cf[c] != 'U') continue;
 
                     cf[c] = 'F';
 
@@ -381,13 +534,16 @@ struct ruge_stuben {
                     for(Ptr aj = A.ptr[c], ae = A.ptr[c + 1]; aj < ae; ++aj) {
                         if (!S.val[aj]) continue;
 
-                        Col ac    = A.col[aj];
-                        Col lam_a = lambda[ac];
+                        Col ac = A.col[aj];
+                        if (ac < beg || ac >= end) continue;
+
+                        Col lc    = ac - beg;
+                        Col lam_a = lambda[lc];
 
-                        if (cf[ac] != 'U' || static_cast<size_t>(lam_a) + 1 >= n)
+                        if (cf[ac] != 'U' || static_cast<ptrdiff_t>(lam_a) + 1 >= n)
                             continue;
 
-                        Ptr old_pos = n2i[ac];
+                        Ptr old_pos = n2i[lc];
                         Ptr new_pos = ptr[lam_a] + cnt[lam_a] - 1;
 
                         n2i[i2n[old_pos]] = new_pos;
@@ -399,20 +555,23 @@ struct ruge_stuben {
                         ++cnt[lam_a + 1];
                         ptr[lam_a + 1] = ptr[lam_a] + cnt[lam_a];
 
-                        lambda[ac] = lam_a + 1;
+                        lambda[lc] = lam_a + 1;
                     }
                 }
 
                 // Decrease lambdas of the newly create C's neighbours.
-                for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; j++) {
+                for(Ptr j = A.ptr[beg + i], e = A.ptr[beg + i + 1]; j < e; j++) {
                     if (!S.val[j]) continue;
 
-                    Col c   = A.col[j];
-                    Col lam = lambda[c];
+                    Col c = A.col[j];
+                    if (c < beg || c >= end) continue;
+
+                    Col lc  = c - beg;
+                    Col lam = lambda[lc];
 
                     if (cf[c] != 'U' || lam == 0) continue;
 
-                    Ptr old_pos = n2i[c];
+                    Ptr old_pos = n2i[lc];
                     Ptr new_pos = ptr[lam];
 
                     n2i[i2n[old_pos]] = new_pos;
@@ -423,9 +582,628 @@ struct ruge_stuben {
                     --cnt[lam];
                     ++cnt[lam - 1];
                     ++ptr[lam];
-                    lambda[c] = lam - 1;
+                    lambda[lc] = lam - 1;
+                }
+            }
+        }
+
+        // Parallel modified independent set (PMIS) splitting.
+        //
+        // The points that are already marked as C on input form the initial
+        // independent set. The measure of each point is the number of
+        // points it strongly influences plus a pseudo-random fraction, which
+        // only depends on the point number, so that the splitting does not
+        // depend on the number of threads.
+        template <typename Val, typename Col, typename Ptr>
+        static void pmis(
+                backend::crs<Val,  Col, Ptr> const &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char>                  &cf
+                )
+        {
+            const ptrdiff_t n = rows(A);
+
+            std::vector<double> measure(n);
+            std::vector<char>   new_cf(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                measure[i] = S.ptr[i + 1] - S.ptr[i]
+                    + amgcl::detail::random_weight(i) / 4294967296.0;
+
+                // Points that do not influence anybody are never needed for
+                // interpolation.
+                if (cf[i] == 'U' && measure[i] < 1) cf[i] = 'F';
+            }
+
+            for(ptrdiff_t left = n; left > 0; ) {
+                // Undecided points that depend on C points become F points.
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    new_cf[i] = cf[i];
+
+                    if (cf[i] != 'U') continue;
+
+                    for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                        if (S.val[j] && cf[A.col[j]] == 'C') {
+                            new_cf[i] = 'F';
+                            break;
+                        }
+                    }
+                }
+
+                cf.swap(new_cf);
+
+                // Undecided points with the maximum measure among undecided
+                // strong neighbours become C points.
+                left = 0;
+
+#pragma omp parallel for reduction(+:left)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    new_cf[i] = cf[i];
+
+                    if (cf[i] != 'U') continue;
+
+                    bool is_max = true;
+
+                    for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; is_max && j < e; ++j) {
+                        if (!S.val[j]) continue;
+
+                        Col c = A.col[j];
+                        if (cf[c] == 'U' && greater(measure, c, i)) is_max = false;
+                    }
+
+                    for(Ptr j = S.ptr[i], e = S.ptr[i + 1]; is_max && j < e; ++j) {
+                        Col c = S.col[j];
+                        if (cf[c] == 'U' && greater(measure, c, i)) is_max = false;
+                    }
+
+                    if (is_max)
+                        new_cf[i] = 'C';
+                    else
+                        ++left;
+                }
+
+                cf.swap(new_cf);
+            }
+        }
+
+        static bool greater(const std::vector<double> &measure, ptrdiff_t a, ptrdiff_t b) {
+            return measure[a] > measure[b] || (measure[a] == measure[b] && a > b);
+        }
+
+        // Hybrid (HMIS) splitting: the C points of the classic splitting of
+        // independent row blocks form the initial independent set for PMIS.
+        template <typename Val, typename Col, typename Ptr>
+        static void hmis(
+                backend::crs<Val,  Col, Ptr> const &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char>                  &cf,
+                ptrdiff_t block_size
+                )
+        {
+            const ptrdiff_t n = rows(A);
+            const ptrdiff_t nblocks = (n + block_size - 1) / block_size;
+
+            std::vector<char> cf_local(cf);
+
+#pragma omp parallel for schedule(dynamic, 1)
+            for(ptrdiff_t b = 0; b < nblocks; ++b) {
+                ptrdiff_t beg = b * block_size;
+                ptrdiff_t end = std::min(n, beg + block_size);
+
+                cfsplit(A, S, cf_local, beg, end);
+            }
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (cf_local[i] == 'C') cf[i] = 'C';
+
+            pmis(A, S, cf);
+        }
+
+        // Extended+i interpolation for the given F point. The C points of
+        // the row are collected in cols (marker maps a column to its
+        // position in cols), and the interpolation weights in vals.
+        template <typename Val, typename Col, typename Ptr>
+        static void extended_i_row(
+                backend::crs<Val,  Col, Ptr> const &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char> const &cf, ptrdiff_t i, const params &prm,
+                std::vector<ptrdiff_t> &marker,
+                std::vector<ptrdiff_t> &cols,
+                std::vector<Val>       &vals
+                )
+        {
+            const Val eps = amgcl::detail::eps<Val>(1);
+
+            cols.clear();
+            vals.clear();
+
+            // Interpolatory set: strong C neighbours of the point and of its
+            // strong F neighbours.
+            for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                if (!S.val[j]) continue;
+
+                Col c = A.col[j];
+
+                if (cf[c] == 'C') {
+                    if (marker[c] < 0) {
+                        marker[c] = cols.size();
+                        cols.push_back(c);
+                    }
+                } else {
+                    for(Ptr jj = A.ptr[c], ee = A.ptr[c + 1]; jj < ee; ++jj) {
+                        Col cc = A.col[jj];
+                        if (S.val[jj] && cf[cc] == 'C' && marker[cc] < 0) {
+                            marker[cc] = cols.size();
+                            cols.push_back(cc);
+                        }
+                    }
+                }
+            }
+
+            vals.resize(cols.size(), 0);
+
+            Val dia = 0;
+
+            for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                Col c = A.col[j];
+                Val v = A.val[j];
+
+                if (c == i) {
+                    dia += v;
+                } else if (marker[c] >= 0) {
+                    vals[marker[c]] += v;
+                } else if (S.val[j] && cf[c] == 'F') {
+                    // Distribute the strong F connection between the
+                    // interpolatory points and the point itself, using
+                    // only the entries of the opposite sign to the diagonal.
+                    Val dia_c = 0;
+                    for(Ptr jj = A.ptr[c], ee = A.ptr[c + 1]; jj < ee; ++jj)
+                        if (A.col[jj] == c) { dia_c = A.val[jj]; break; }
+
+                    Val sum = 0;
+                    for(Ptr jj = A.ptr[c], ee = A.ptr[c + 1]; jj < ee; ++jj) {
+                        Col cc = A.col[jj];
+                        Val vv = A.val[jj];
+
+                        if ((cc == i || marker[cc] >= 0) && vv * dia_c < 0) sum += vv;
+                    }
+
+                    if (fabs(sum) < eps) {
+                        dia += v;
+                        continue;
+                    }
+
+                    Val scale = v / sum;
+
+                    for(Ptr jj = A.ptr[c], ee = A.ptr[c + 1]; jj < ee; ++jj) {
+                        Col cc = A.col[jj];
+                        Val vv = A.val[jj];
+
+                        if (vv * dia_c >= 0) continue;
+
+                        if (cc == i)
+                            dia += scale * vv;
+                        else if (marker[cc] >= 0)
+                            vals[marker[cc]] += scale * vv;
+                    }
+                } else {
+                    // Weak connections are lumped to the diagonal.
+                    dia += v;
+                }
+            }
+
+            BOOST_FOREACH(ptrdiff_t c, cols) marker[c] = -1;
+
+            if (fabs(dia) < eps) {
+                cols.clear();
+                vals.clear();
+                return;
+            }
+
+            for(size_t k = 0; k < vals.size(); ++k) vals[k] = -vals[k] / dia;
+
+            if (prm.do_trunc) truncate_row(prm.eps_trunc, cols, vals);
+        }
+
+        // Drops the weights that are smaller than the largest one by the
+        // factor of eps_trunc, and rescales the rest to keep the row sum.
+        template <typename Val>
+        static void truncate_row(float eps_trunc,
+                std::vector<ptrdiff_t> &cols, std::vector<Val> &vals)
+        {
+            const Val eps = amgcl::detail::eps<Val>(1);
+
+            if (vals.empty()) return;
+
+            Val wmax = 0, sum_all = 0;
+            for(size_t k = 0; k < vals.size(); ++k) {
+                wmax     = std::max(wmax, static_cast<Val>(fabs(vals[k])));
+                sum_all += vals[k];
+            }
+
+            Val sum_kept = 0;
+            size_t m = 0;
+            for(size_t k = 0; k < vals.size(); ++k) {
+                if (fabs(vals[k]) < eps_trunc * wmax) continue;
+
+                sum_kept += vals[k];
+                cols[m]   = cols[k];
+                vals[m]   = vals[k];
+                ++m;
+            }
+
+            cols.resize(m);
+            vals.resize(m);
+
+            if (fabs(sum_kept) > eps) {
+                Val scale = sum_all / sum_kept;
+                for(size_t k = 0; k < m; ++k) vals[k] *= scale;
+            }
+        }
+
+        template <class Matrix, typename Col, typename Ptr>
+        static boost::shared_ptr<Matrix> extended_i(
+                const Matrix &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char> const &cf,
+                std::vector<ptrdiff_t> const &cidx, size_t nc,
+                const params &prm
+                )
+        {
+            typedef typename backend::value_type<Matrix>::type Val;
+            const ptrdiff_t n = rows(A);
+
+            boost::shared_ptr<Matrix> P = boost::make_shared<Matrix>();
+            P->nrows = n;
+            P->ncols = nc;
+            P->ptr.resize(n + 1, 0);
+
+            // The rows are computed twice (first to count the nonzeros, then
+            // to fill the matrix) to avoid storing them in between.
+            for(int pass = 0; pass < 2; ++pass) {
+                if (pass) {
+                    boost::partial_sum(P->ptr, P->ptr.begin());
+                    P->col.resize(P->ptr.back());
+                    P->val.resize(P->ptr.back());
+                }
+
+#pragma omp parallel
+                {
+                    std::vector<ptrdiff_t> marker(n, -1);
+                    std::vector<ptrdiff_t> cols;
+                    std::vector<Val>       vals;
+
+#pragma omp for schedule(dynamic, 1024)
+                    for(ptrdiff_t i = 0; i < n; ++i) {
+                        if (cf[i] == 'C') {
+                            if (pass) {
+                                P->col[P->ptr[i]] = cidx[i];
+                                P->val[P->ptr[i]] = 1;
+                            } else {
+                                P->ptr[i + 1] = 1;
+                            }
+                            continue;
+                        }
+
+                        extended_i_row(A, S, cf, i, prm, marker, cols, vals);
+
+                        if (pass) {
+                            for(size_t k = 0, h = P->ptr[i]; k < cols.size(); ++k, ++h) {
+                                P->col[h] = cidx[cols[k]];
+                                P->val[h] = vals[k];
+                            }
+
+                            amgcl::detail::sort_row(
+                                    &P->col[P->ptr[i]], &P->val[P->ptr[i]],
+                                    static_cast<int>(cols.size()));
+                        } else {
+                            P->ptr[i + 1] = cols.size();
+                        }
+                    }
+                }
+            }
+
+            return P;
+        }
+
+        // Second splitting of aggressive coarsening. The C points of the
+        // splitting are split once more with PMIS, using the distance-two
+        // strong connectivity between them: two C points are connected when
+        // there is a path of length at most two between them in the strong
+        // connectivity graph. The classic splitting is not used here, since
+        // the distance-two graph is too dense for it.
+        template <typename Val, typename Col, typename Ptr>
+        static void aggressive_split(
+                backend::crs<Val,  Col, Ptr> const &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char>                  &cf
+                )
+        {
+            const ptrdiff_t n = rows(A);
+
+            std::vector<ptrdiff_t> cidx(n, -1);
+            std::vector<ptrdiff_t> cpts;
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (cf[i] != 'C') continue;
+                cidx[i] = cpts.size();
+                cpts.push_back(i);
+            }
+
+            const ptrdiff_t nc = cpts.size();
+
+            // The pattern of the distance-two connectivity is stored in A2,
+            // and S2 is set up the same way connect() sets up S.
+            backend::crs<char, Col, Ptr> A2, S2;
+            A2.nrows = A2.ncols = nc;
+            A2.ptr.resize(nc + 1, 0);
+
+            for(int sweep = 0; sweep < 2; ++sweep) {
+                if (sweep) {
+                    boost::partial_sum(A2.ptr, A2.ptr.begin());
+                    A2.col.resize(A2.ptr.back());
+                    A2.val.resize(A2.ptr.back(), 1);
+                }
+
+#pragma omp parallel
+                {
+                    std::vector<ptrdiff_t> marker(nc, -1);
+                    std::vector<Col>       nbr;
+
+#pragma omp for
+                    for(ptrdiff_t ic = 0; ic < nc; ++ic) {
+                        ptrdiff_t i    = cpts[ic];
+                        Ptr       head = sweep ? A2.ptr[ic] : 0;
+
+                        // Strong neighbours of the point and of its strong
+                        // neighbours.
+                        nbr.clear();
+                        for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                            if (!S.val[j]) continue;
+
+                            Col c = A.col[j];
+                            nbr.push_back(c);
+
+                            for(Ptr jj = A.ptr[c], ee = A.ptr[c + 1]; jj < ee; ++jj)
+                                if (S.val[jj]) nbr.push_back(A.col[jj]);
+                        }
+
+                        BOOST_FOREACH(Col c, nbr) {
+                            ptrdiff_t k = cidx[c];
+
+                            if (c == i || k < 0 || marker[k] == ic) continue;
+
+                            marker[k] = ic;
+
+                            if (sweep)
+                                A2.col[head++] = k;
+                            else
+                                ++A2.ptr[ic + 1];
+                        }
+                    }
+                }
+            }
+
+            S2.nrows = S2.ncols = nc;
+            S2.val.resize(A2.ptr.back(), 1);
+            S2.ptr.resize(nc + 1, 0);
+
+            for(Ptr j = 0; j < A2.ptr.back(); ++j)
+                ++S2.ptr[A2.col[j] + 1];
+
+            boost::partial_sum(S2.ptr, S2.ptr.begin());
+            S2.col.resize(S2.ptr.back());
+
+            for(ptrdiff_t i = 0; i < nc; ++i)
+                for(Ptr j = A2.ptr[i], e = A2.ptr[i + 1]; j < e; ++j)
+                    S2.col[ S2.ptr[ A2.col[j] ]++ ] = i;
+
+            std::rotate(S2.ptr.begin(), S2.ptr.end() - 1, S2.ptr.end());
+            S2.ptr.front() = 0;
+
+            std::vector<char> cf2(nc, 'U');
+            pmis(A2, S2, cf2);
+
+            for(ptrdiff_t ic = 0; ic < nc; ++ic)
+                if (cf2[ic] != 'C') cf[cpts[ic]] = 'F';
+        }
+
+        // Multipass interpolation \cite Stuben1999 for aggressive coarsening.
+        //
+        // F points with strong C neighbours are interpolated directly in the
+        // first pass. In each of the following passes, the F points that
+        // have strong neighbours interpolated in the previous passes use
+        // direct interpolation from those neighbours, which is then
+        // substituted with the neighbours' interpolation formulae. Positive
+        // couplings are lumped to the diagonal.
+        template <class Matrix, typename Col, typename Ptr>
+        static boost::shared_ptr<Matrix> multipass(
+                const Matrix &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char> const &cf,
+                std::vector<ptrdiff_t> const &cidx, size_t nc,
+                const params &prm
+                )
+        {
+            typedef typename backend::value_type<Matrix>::type Val;
+            const ptrdiff_t n = rows(A);
+            const Val eps = amgcl::detail::eps<Val>(1);
+
+            // Pass number for each point. C points belong to pass 0; points
+            // that are never reached have no interpolation.
+            std::vector<int> pass(n, -1), new_pass(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (cf[i] == 'C') pass[i] = 0;
+
+            int npass = 1;
+            for(;; ++npass) {
+                ptrdiff_t found = 0;
+
+#pragma omp parallel for reduction(+:found)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    new_pass[i] = pass[i];
+                    if (pass[i] >= 0) continue;
+
+                    for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                        if (S.val[j] && pass[A.col[j]] >= 0) {
+                            new_pass[i] = npass;
+                            ++found;
+                            break;
+                        }
+                    }
                 }
+
+                if (!found) break;
+                pass.swap(new_pass);
+            }
+
+            // Points ordered by pass.
+            std::vector<ptrdiff_t> pptr(npass + 1, 0);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (pass[i] >= 0) ++pptr[pass[i] + 1];
+
+            boost::partial_sum(pptr, pptr.begin());
+
+            std::vector<ptrdiff_t> order(pptr.back());
+            {
+                std::vector<ptrdiff_t> head(pptr.begin(), pptr.end() - 1);
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    if (pass[i] >= 0) order[head[pass[i]]++] = i;
+            }
+
+            // Interpolation formula of each point (in terms of the coarse
+            // points), stored pass by pass.
+            std::vector<ptrdiff_t> wbeg(n, 0), wlen(n, 0);
+            std::vector<ptrdiff_t> wcol(pptr[1]);
+            std::vector<Val>       wval(pptr[1], static_cast<Val>(1));
+
+            for(ptrdiff_t k = 0; k < pptr[1]; ++k) {
+                ptrdiff_t i = order[k];
+                wbeg[i] = k;
+                wlen[i] = 1;
+                wcol[k] = cidx[i];
             }
+
+            for(int p = 1; p < npass; ++p) {
+                const ptrdiff_t beg = pptr[p];
+                const ptrdiff_t end = pptr[p + 1];
+
+                // The rows are computed twice (first to count the nonzeros,
+                // then to store them).
+                for(int sweep = 0; sweep < 2; ++sweep) {
+                    if (sweep) {
+                        ptrdiff_t offset = wcol.size();
+                        for(ptrdiff_t k = beg; k < end; ++k) {
+                            ptrdiff_t i = order[k];
+                            wbeg[i]  = offset;
+                            offset  += wlen[i];
+                        }
+
+                        wcol.resize(offset);
+                        wval.resize(offset);
+                    }
+
+#pragma omp parallel
+                    {
+                        std::vector<ptrdiff_t> marker(nc, -1);
+                        std::vector<ptrdiff_t> cols;
+                        std::vector<Val>       vals;
+
+#pragma omp for schedule(dynamic, 1024)
+                        for(ptrdiff_t k = beg; k < end; ++k) {
+                            ptrdiff_t i = order[k];
+
+                            cols.clear();
+                            vals.clear();
+
+                            Val dia = 0, a_all = 0, a_int = 0;
+
+                            for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                                Col c = A.col[j];
+                                Val v = A.val[j];
+
+                                if (c == i || v > 0) {
+                                    dia += v;
+                                } else {
+                                    a_all += v;
+                                    if (S.val[j] && pass[c] >= 0 && pass[c] < p)
+                                        a_int += v;
+                                }
+                            }
+
+                            if (fabs(dia) > eps && fabs(a_int) > eps) {
+                                Val alpha = -a_all / (a_int * dia);
+
+                                for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                                    Col c = A.col[j];
+
+                                    if (!S.val[j] || pass[c] < 0 || pass[c] >= p)
+                                        continue;
+
+                                    Val w = alpha * A.val[j];
+
+                                    for(ptrdiff_t q = wbeg[c], qe = q + wlen[c]; q < qe; ++q) {
+                                        ptrdiff_t cc = wcol[q];
+
+                                        if (marker[cc] < 0) {
+                                            marker[cc] = cols.size();
+                                            cols.push_back(cc);
+                                            vals.push_back(w * wval[q]);
+                                        } else {
+                                            vals[marker[cc]] += w * wval[q];
+                                        }
+                                    }
+                                }
+
+                                BOOST_FOREACH(ptrdiff_t c, cols) marker[c] = -1;
+
+                                if (prm.do_trunc) truncate_row(prm.eps_trunc, cols, vals);
+                            }
+
+                            if (sweep) {
+                                std::copy(cols.begin(), cols.end(), wcol.begin() + wbeg[i]);
+                                std::copy(vals.begin(), vals.end(), wval.begin() + wbeg[i]);
+                            } else {
+                                wlen[i] = cols.size();
+                            }
+                        }
+                    }
+                }
+            }
+
+            boost::shared_ptr<Matrix> P = boost::make_shared<Matrix>();
+            P->nrows = n;
+            P->ncols = nc;
+            P->ptr.resize(n + 1, 0);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                P->ptr[i + 1] = wlen[i];
+
+            boost::partial_sum(P->ptr, P->ptr.begin());
+            P->col.resize(P->ptr.back());
+            P->val.resize(P->ptr.back());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t h = P->ptr[i];
+
+                for(ptrdiff_t q = wbeg[i], e = q + wlen[i]; q < e; ++q, ++h) {
+                    P->col[h] = wcol[q];
+                    P->val[h] = wval[q];
+                }
+
+                if (wlen[i] > 1)
+                    amgcl::detail::sort_row(&P->col[P->ptr[i]], &P->val[P->ptr[i]],
+                            static_cast<int>(wlen[i]));
+            }
+
+            return P;
         }
 };
 
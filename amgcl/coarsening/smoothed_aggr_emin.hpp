@@ -41,161 +41,44 @@ THE SOFTWARE.
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/detail/galerkin.hpp>
+#include <amgcl/coarsening/detail/aggregates.hpp>
+#include <amgcl/coarsening/detail/truncate.hpp>
 #include <amgcl/util.hpp>
-#include <amgcl/detail/sort_row.hpp>
 
 namespace amgcl {
 namespace coarsening {
 namespace detail {
 
-template <class Base>
-struct sa_emin_filtered_matrix {
-    typedef typename backend::value_type<Base>::type value_type;
-
-    typedef value_type val_type;
-    typedef ptrdiff_t  col_type;
-    typedef ptrdiff_t  ptr_type;
-
-    const Base &base;
-    const std::vector<char> &strong;
-    std::vector<val_type> dia;
-
-    class row_iterator {
-        public:
-            row_iterator(
-                    const col_type * col,
-                    const col_type * end,
-                    const val_type * val,
-                    const char     * str,
-                    col_type row,
-                    val_type dia
-                    )
-                : m_col(col), m_end(end), m_val(val), m_str(str),
-                  m_row(row), m_dia(dia)
-            {}
-
-            operator bool() const {
-                return m_col < m_end;
-            }
-
-            row_iterator& operator++() {
-                do {
-                    ++m_col;
-                    ++m_val;
-                    ++m_str;
-                } while(m_col < m_end && m_col[0] != m_row && !m_str[0]);
-
-                return *this;
-            }
-
-            col_type col() const {
-                return *m_col;
-            }
-
-            val_type value() const {
-                if (m_col[0] == m_row)
-                    return m_dia;
-                else
-                    return m_val[0];
-            }
-
-        private:
-            const col_type * m_col;
-            const col_type * m_end;
-            const val_type * m_val;
-            const char     * m_str;
-
-            col_type m_row;
-            val_type m_dia;
-    };
+/// Inverted diagonal of the filtered matrix.
+/**
+ * The filtered matrix for the energy minimizing smoothed aggregation is the
+ * system matrix with its weak off-diagonal connections dropped and lumped to
+ * the diagonal. It is never formed explicitly: the products with the matrix
+ * skip the weak connections on the fly, and only the diagonal is stored.
+ */
+template <typename Val, typename Col, typename Ptr>
+std::vector<Val> sa_emin_filtered_diagonal(
+        const backend::crs<Val, Col, Ptr> &A, const std::vector<char> &strong)
+{
+    const ptrdiff_t n = backend::rows(A);
+    std::vector<Val> dinv(n);
 
-    sa_emin_filtered_matrix(
-            const Base &base,
-            const std::vector<char> &strong
-            ) : base(base), strong(strong), dia( backend::rows(base) )
-    {
-        const size_t n = backend::rows(base);
 #pragma omp parallel for
-        for(ptrdiff_t i = 0; i < ptrdiff_t(n); ++i) {
-            value_type D = 0;
-            for(ptrdiff_t j = base.ptr[i], e = base.ptr[i + 1]; j < e; ++j) {
-                ptrdiff_t  c = base.col[j];
-                value_type v = base.val[j];
-
-                if (c == i)
-                    D += v;
-                else if (!strong[j])
-                    D -= v;
-            }
-
-            dia[i] = D;
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        Val D = 0;
+        for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+            if (A.col[j] == i)
+                D += A.val[j];
+            else if (!strong[j])
+                D -= A.val[j];
         }
+        dinv[i] = 1 / D;
     }
 
-    size_t rows() const {
-        return backend::rows(base);
-    }
-
-    size_t cols() const {
-        return backend::cols(base);
-    }
-
-    row_iterator row_begin(size_t row) const {
-        ptr_type b = base.ptr[row];
-        ptr_type e = base.ptr[row + 1];
-
-        const col_type *col = &base.col[b];
-        const col_type *end = &base.col[e];
-        const val_type *val = &base.val[b];
-        const char     *str = &strong[b];
-
-        return row_iterator(col, end, val, str, row, dia[row]);
-    }
-};
+    return dinv;
+}
 
 } // namespace detail
-} // namespace coarsening
-
-namespace backend {
-
-template <class Base>
-struct rows_impl< coarsening::detail::sa_emin_filtered_matrix<Base> > {
-    typedef coarsening::detail::sa_emin_filtered_matrix<Base> Matrix;
-
-    static size_t get(const Matrix &A) {
-        return A.rows();
-    }
-};
-
-template <class Base>
-struct cols_impl< coarsening::detail::sa_emin_filtered_matrix<Base> > {
-    typedef coarsening::detail::sa_emin_filtered_matrix<Base> Matrix;
-
-    static size_t get(const Matrix &A) {
-        return A.cols();
-    }
-};
-
-template <class Base>
-struct row_iterator< coarsening::detail::sa_emin_filtered_matrix<Base> > {
-    typedef
-        typename coarsening::detail::sa_emin_filtered_matrix<Base>::row_iterator
-        type;
-};
-
-template <class Base>
-struct row_begin_impl< coarsening::detail::sa_emin_filtered_matrix<Base> > {
-    typedef coarsening::detail::sa_emin_filtered_matrix<Base> Matrix;
-
-    static typename row_iterator<Matrix>::type
-    get(const Matrix &matrix, size_t row) {
-        return matrix.row_begin(row);
-    }
-};
-
-} // namespace backend
-
-namespace coarsening {
 
 /// Smoothed aggregation with energy minimization.
 /**
@@ -213,16 +96,52 @@ struct smoothed_aggr_emin {
         /// Near nullspace parameters.
         nullspace_params nullspace;
 
-        params() {}
+        /// Number of the first levels that use aggressive coarsening.
+        /**
+         * \copydetails amgcl::coarsening::aggregation::params::aggressive_levels
+         */
+        unsigned aggressive_levels;
+
+        /// Truncation parameter for the transfer operators.
+        /**
+         * \copydetails amgcl::coarsening::smoothed_aggregation::params::eps_trunc
+         *
+         * The restriction operator is truncated in the same way (columnwise).
+         */
+        float eps_trunc;
+
+        /// Maximum number of nonzero entries per row of the prolongation.
+        /**
+         * \copydetails amgcl::coarsening::smoothed_aggregation::params::trunc_max_nnz
+         */
+        unsigned trunc_max_nnz;
+
+        /// Filtering parameter for the coarse operators.
+        /**
+         * \copydetails amgcl::coarsening::smoothed_aggregation::params::eps_filter
+         */
+        float eps_filter;
+
+        params()
+            : aggressive_levels(0), eps_trunc(0), trunc_max_nnz(0), eps_filter(0)
+        {}
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_CHILD(p, aggr),
-              AMGCL_PARAMS_IMPORT_CHILD(p, nullspace)
+              AMGCL_PARAMS_IMPORT_CHILD(p, nullspace),
+              AMGCL_PARAMS_IMPORT_VALUE(p, aggressive_levels),
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, trunc_max_nnz),
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_filter)
         {}
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_CHILD(p, path, aggr);
             AMGCL_PARAMS_EXPORT_CHILD(p, path, nullspace);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, aggressive_levels);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_trunc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, trunc_max_nnz);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_filter);
         }
     };
 
@@ -238,6 +157,12 @@ struct smoothed_aggr_emin {
 
         TIC("aggregates");
         Aggregates aggr(A, prm.aggr);
+
+        if (prm.aggressive_levels > 0) {
+            --prm.aggressive_levels;
+            detail::aggregate_aggregates(A, prm.aggr, aggr);
+        }
+        detail::coarse_aggregates_params<Aggregates>::apply(prm.aggr, aggr);
         prm.aggr.eps_strong *= 0.5;
         TOC("aggregates");
 
@@ -246,11 +171,20 @@ struct smoothed_aggr_emin {
                 rows(A), aggr.count, aggr.id, prm.nullspace
                 );
 
+        const std::vector<char> &S = aggr.strong_connection;
+        std::vector<Val> dinv = detail::sa_emin_filtered_diagonal(A, S);
         std::vector<Val> omega;
-        detail::sa_emin_filtered_matrix<Matrix> Af(A, aggr.strong_connection);
 
-        boost::shared_ptr<Matrix> P = interpolation(Af, *P_tent, omega);
-        boost::shared_ptr<Matrix> R = restriction  (Af, *P_tent, omega);
+        boost::shared_ptr<Matrix> P = interpolation(A, S, dinv, *P_tent, omega);
+        boost::shared_ptr<Matrix> R = restriction  (A, S, dinv, *P_tent, omega);
+
+        if (prm.eps_trunc > 0 || prm.trunc_max_nnz > 0) {
+            detail::truncate(*P, prm.eps_trunc, prm.trunc_max_nnz);
+
+            Matrix Rt = transpose(*R);
+            detail::truncate(Rt, prm.eps_trunc, prm.trunc_max_nnz);
+            *R = transpose(Rt);
+        }
         TOC("interpolation");
 
         return boost::make_tuple(P, R);
@@ -262,70 +196,134 @@ struct smoothed_aggr_emin {
             const Matrix &A,
             const Matrix &P,
             const Matrix &R,
-            const params&
+            const params &prm
             )
     {
-        return detail::galerkin(A, P, R);
+        boost::shared_ptr<Matrix> Ac = detail::galerkin(A, P, R);
+
+        if (prm.eps_filter > 0) detail::filter(*Ac, prm.eps_filter);
+
+        return Ac;
     }
 
     private:
-        template <class AMatrix, typename Val, typename Col, typename Ptr>
+        // Computes P = (I - D^-1 A Omega) P_tent, where A is the filtered
+        // matrix, and Omega is the diagonal matrix of the columnwise damping
+        // parameters minimizing the energy of the prolongation columns.
+        template <typename Val, typename Col, typename Ptr>
         static boost::shared_ptr< backend::crs<Val, Col, Ptr> >
         interpolation(
-                const AMatrix &A,
+                const backend::crs<Val, Col, Ptr> &A,
+                const std::vector<char> &S,
+                const std::vector<Val> &dinv,
                 const backend::crs<Val, Col, Ptr> &P_tent,
                 std::vector<Val> &omega
                 )
         {
             typedef backend::crs<Val, Col, Ptr> PMatrix;
 
-            typedef typename PMatrix::row_iterator Piterator;
-            typedef typename AMatrix::row_iterator Aiterator;
-
-            const size_t n  = rows(P_tent);
-            const size_t nc = cols(P_tent);
+            const ptrdiff_t n  = rows(P_tent);
+            const ptrdiff_t nc = cols(P_tent);
 
+            // AP = A * P_tent, with the weak connections of A skipped.
             boost::shared_ptr<PMatrix> AP = boost::make_shared<PMatrix>();
+            AP->nrows = n;
+            AP->ncols = nc;
+            AP->ptr.resize(n + 1);
+            AP->ptr[0] = 0;
+
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(nc, -1);
+
+#pragma omp for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    Ptr cnt = 0;
+
+                    for(Ptr ja = A.ptr[i], ea = A.ptr[i + 1]; ja < ea; ++ja) {
+                        Col ca = A.col[ja];
+                        if (ca != i && !S[ja]) continue;
+
+                        for(Ptr jp = P_tent.ptr[ca], ep = P_tent.ptr[ca + 1]; jp < ep; ++jp) {
+                            Col cp = P_tent.col[jp];
+                            if (marker[cp] != i) {
+                                marker[cp] = i;
+                                ++cnt;
+                            }
+                        }
+                    }
 
-            *AP = product(A, P_tent, /*sort rows: */true);
+                    AP->ptr[i + 1] = cnt;
+                }
+            }
 
-            omega.resize(nc, Val(0));
-            std::vector<Val> denum(nc, 0);
+            boost::partial_sum(AP->ptr, AP->ptr.begin());
+            AP->col.resize(AP->ptr.back());
+            AP->val.resize(AP->ptr.back());
 
 #pragma omp parallel
             {
-#ifdef _OPENMP
-                int nt  = omp_get_num_threads();
-                int tid = omp_get_thread_num();
-
-                size_t chunk_size  = (n + nt - 1) / nt;
-                size_t chunk_start = tid * chunk_size;
-                size_t chunk_end   = std::min(n, chunk_start + chunk_size);
-#else
-                size_t chunk_start = 0;
-                size_t chunk_end   = n;
-#endif
-
                 std::vector<ptrdiff_t> marker(nc, -1);
 
-                // Compute A * Dinv * AP row by row and compute columnwise
-                // scalar products necessary for computation of omega. The
-                // actual results of matrix-matrix product are not stored.
-                std::vector<Col> adap_col(128);
-                std::vector<Val> adap_val(128);
+#pragma omp for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    Ptr row_beg = AP->ptr[i];
+                    Ptr row_end = row_beg;
+
+                    for(Ptr ja = A.ptr[i], ea = A.ptr[i + 1]; ja < ea; ++ja) {
+                        Col ca = A.col[ja];
+                        if (ca != i && !S[ja]) continue;
+
+                        Val va = (ca == i) ? 1 / dinv[i] : A.val[ja];
+
+                        for(Ptr jp = P_tent.ptr[ca], ep = P_tent.ptr[ca + 1]; jp < ep; ++jp) {
+                            Col cp = P_tent.col[jp];
+                            Val vp = P_tent.val[jp];
+
+                            if (marker[cp] < row_beg) {
+                                marker[cp] = row_end;
+                                AP->col[row_end] = cp;
+                                AP->val[row_end] = va * vp;
+                                ++row_end;
+                            } else {
+                                AP->val[marker[cp]] += va * vp;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Columnwise scalar products (AP, ADAP) and (ADAP, ADAP), where
+            // ADAP = A * D^-1 * AP. Rows of ADAP are formed one at a time and
+            // are not stored. The products are accumulated in thread-local
+            // vectors, so the main loop needs no synchronization.
+            omega.resize(nc);
+            boost::fill(omega, Val(0));
+            std::vector<Val> denum(nc, Val(0));
 
-                for(size_t ia = chunk_start; ia < chunk_end; ++ia) {
+#pragma omp parallel
+            {
+                std::vector<Val> num(nc, Val(0));
+                std::vector<Val> den(nc, Val(0));
+
+                std::vector<ptrdiff_t> marker(nc, -1);
+                std::vector<Col> adap_col;
+                std::vector<Val> adap_val;
+
+#pragma omp for
+                for(ptrdiff_t i = 0; i < n; ++i) {
                     adap_col.clear();
                     adap_val.clear();
 
-                    // Form current row of ADAP matrix.
-                    for(Aiterator a = A.row_begin(ia); a; ++a) {
-                        Col ca  = a.col();
-                        Val va  = a.value() / A.dia[ca];
+                    for(Ptr ja = A.ptr[i], ea = A.ptr[i + 1]; ja < ea; ++ja) {
+                        Col ca = A.col[ja];
+                        if (ca != i && !S[ja]) continue;
+
+                        Val va = (ca == i) ? Val(1) : A.val[ja] * dinv[ca];
 
-                        for(Piterator p = AP->row_begin(ca); p; ++p) {
-                            Col c = p.col();
-                            Val v = va * p.value();
+                        for(Ptr jp = AP->ptr[ca], ep = AP->ptr[ca + 1]; jp < ep; ++jp) {
+                            Col c = AP->col[jp];
+                            Val v = va * AP->val[jp];
 
                             if (marker[c] < 0) {
                                 marker[c] = adap_col.size();
@@ -337,42 +335,27 @@ struct smoothed_aggr_emin {
                         }
                     }
 
-                    amgcl::detail::sort_row(
-                            adap_col.data(), adap_val.data(), adap_col.size()
-                            );
-
-                    // Update columnwise scalar products (AP,ADAP) and (ADAP,ADAP).
-                    // 1. (AP, ADAP)
-                    for(
-                            Ptr ja = AP->ptr[ia], ea = AP->ptr[ia + 1],
-                            jb = 0, eb = adap_col.size();
-                            ja < ea && jb < eb;
-                       )
-                    {
-                        Col ca = AP->col[ja];
-                        Col cb = adap_col[jb];
-
-                        if (ca < cb)
-                            ++ja;
-                        else if (cb < ca)
-                            ++jb;
-                        else /*ca == cb*/ {
-#pragma omp atomic
-                            omega[ca] += AP->val[ja] * adap_val[jb];
-                            ++ja;
-                            ++jb;
-                        }
+                    // The marker gives the position of a column in the
+                    // current ADAP row, so neither row has to be sorted.
+                    for(Ptr ja = AP->ptr[i], ea = AP->ptr[i + 1]; ja < ea; ++ja) {
+                        Col c = AP->col[ja];
+                        if (marker[c] >= 0)
+                            num[c] += AP->val[ja] * adap_val[marker[c]];
                     }
 
-                    // 2. (ADAP, ADAP) (and clear marker)
                     for(size_t j = 0, e = adap_col.size(); j < e; ++j) {
                         Col c = adap_col[j];
                         Val v = adap_val[j];
-#pragma omp atomic
-                        denum[c] += v * v;
+                        den[c] += v * v;
                         marker[c] = -1;
                     }
                 }
+
+#pragma omp critical
+                for(ptrdiff_t c = 0; c < nc; ++c) {
+                    omega[c] += num[c];
+                    denum[c] += den[c];
+                }
             }
 
             boost::transform(omega, denum, omega.begin(), std::divides<Val>());
@@ -385,88 +368,134 @@ struct smoothed_aggr_emin {
              * AP(i,j) = sum_k(A_ik P_kj), and A_ii != 0.
              */
 #pragma omp parallel for
-            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i) {
-                Val dia = 1 / A.dia[i];
-
-                for(Ptr ja = AP->ptr[i],    ea = AP->ptr[i+1],
-                        jp = P_tent.ptr[i], ep = P_tent.ptr[i+1];
-                        ja < ea; ++ja
-                   )
-                {
-                    Col ca = AP->col[ja];
-                    Val va = -dia * AP->val[ja] * omega[ca];
-
-                    for(; jp < ep; ++jp) {
-                        Col cp = P_tent.col[jp];
-                        if (cp > ca)
-                            break;
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                Ptr row_beg = AP->ptr[i];
+                Ptr row_end = AP->ptr[i + 1];
+
+                Val dia = dinv[i];
+
+                for(Ptr ja = row_beg; ja < row_end; ++ja)
+                    AP->val[ja] *= -dia * omega[AP->col[ja]];
 
-                        if (cp == ca) {
-                            va += P_tent.val[jp];
+                for(Ptr jp = P_tent.ptr[i], ep = P_tent.ptr[i + 1]; jp < ep; ++jp) {
+                    Col cp = P_tent.col[jp];
+
+                    for(Ptr ja = row_beg; ja < row_end; ++ja) {
+                        if (AP->col[ja] == cp) {
+                            AP->val[ja] += P_tent.val[jp];
                             break;
                         }
                     }
-
-                    AP->val[ja] = va;
                 }
             }
 
             return AP;
         }
 
-        template <typename AMatrix, typename Val, typename Col, typename Ptr>
+        // Computes R = R_tent (I - Omega A D^-1), where R_tent is the
+        // transpose of P_tent. The update is applied to each row of R_tent A
+        // as soon as the row is formed.
+        template <typename Val, typename Col, typename Ptr>
         static boost::shared_ptr< backend::crs<Val, Col, Ptr> >
         restriction(
-                const AMatrix &A,
+                const backend::crs<Val, Col, Ptr> &A,
+                const std::vector<char> &S,
+                const std::vector<Val> &dinv,
                 const backend::crs<Val, Col, Ptr> &P_tent,
                 const std::vector<Val> &omega
                 )
         {
             typedef backend::crs<Val, Col, Ptr> PMatrix;
 
-            const size_t nc = cols(P_tent);
+            const ptrdiff_t n  = rows(P_tent);
+            const ptrdiff_t nc = cols(P_tent);
 
             PMatrix R_tent = transpose(P_tent);
-            sort_rows(R_tent);
 
-            boost::shared_ptr<PMatrix> RA = boost::make_shared<PMatrix>();
-            *RA = product(R_tent, A, /*sort rows: */true);
+            boost::shared_ptr<PMatrix> R = boost::make_shared<PMatrix>();
+            R->nrows = nc;
+            R->ncols = n;
+            R->ptr.resize(nc + 1);
+            R->ptr[0] = 0;
 
-            // Compute R = R_tent - Omega R_tent A D^-1.
-            /*
-             * Here we use the fact that if R(i,j) != 0,
-             * then with necessity RA(i,j) != 0:
-             *
-             * RA(i,j) = sum_k(R_ik A_kj), and A_jj != 0.
-             */
-#pragma omp parallel for
-            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nc); ++i) {
-                Val w = omega[i];
-
-                for(Ptr ja = RA->ptr[i],    ea = RA->ptr[i+1],
-                        jr = R_tent.ptr[i], er = R_tent.ptr[i+1];
-                        ja < ea; ++ja
-                   )
-                {
-                    Col ca = RA->col[ja];
-                    Val va = -w * RA->val[ja] / A.dia[ca];
-
-                    for(; jr < er; ++jr) {
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(n, -1);
+
+#pragma omp for
+                for(ptrdiff_t i = 0; i < nc; ++i) {
+                    Ptr cnt = 0;
+
+                    for(Ptr jr = R_tent.ptr[i], er = R_tent.ptr[i + 1]; jr < er; ++jr) {
                         Col cr = R_tent.col[jr];
-                        if (cr > ca)
-                            break;
 
-                        if (cr == ca) {
-                            va += R_tent.val[jr];
-                            break;
+                        for(Ptr ja = A.ptr[cr], ea = A.ptr[cr + 1]; ja < ea; ++ja) {
+                            Col ca = A.col[ja];
+                            if (ca != cr && !S[ja]) continue;
+
+                            if (marker[ca] != i) {
+                                marker[ca] = i;
+                                ++cnt;
+                            }
+                        }
+                    }
+
+                    R->ptr[i + 1] = cnt;
+                }
+            }
+
+            boost::partial_sum(R->ptr, R->ptr.begin());
+            R->col.resize(R->ptr.back());
+            R->val.resize(R->ptr.back());
+
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(n, -1);
+
+#pragma omp for
+                for(ptrdiff_t i = 0; i < nc; ++i) {
+                    Ptr row_beg = R->ptr[i];
+                    Ptr row_end = row_beg;
+
+                    for(Ptr jr = R_tent.ptr[i], er = R_tent.ptr[i + 1]; jr < er; ++jr) {
+                        Col cr = R_tent.col[jr];
+                        Val vr = R_tent.val[jr];
+
+                        for(Ptr ja = A.ptr[cr], ea = A.ptr[cr + 1]; ja < ea; ++ja) {
+                            Col ca = A.col[ja];
+                            if (ca != cr && !S[ja]) continue;
+
+                            Val va = (ca == cr) ? 1 / dinv[cr] : A.val[ja];
+
+                            if (marker[ca] < row_beg) {
+                                marker[ca] = row_end;
+                                R->col[row_end] = ca;
+                                R->val[row_end] = vr * va;
+                                ++row_end;
+                            } else {
+                                R->val[marker[ca]] += vr * va;
+                            }
                         }
                     }
 
-                    RA->val[ja] = va;
+                    // R = R_tent - Omega R_tent A D^-1.
+                    /*
+                     * Here we use the fact that if R(i,j) != 0,
+                     * then with necessity RA(i,j) != 0:
+                     *
+                     * RA(i,j) = sum_k(R_ik A_kj), and A_jj != 0.
+                     */
+                    Val w = omega[i];
+
+                    for(Ptr j = row_beg; j < row_end; ++j)
+                        R->val[j] *= -w * dinv[R->col[j]];
+
+                    for(Ptr jr = R_tent.ptr[i], er = R_tent.ptr[i + 1]; jr < er; ++jr)
+                        R->val[marker[R_tent.col[jr]]] += R_tent.val[jr];
                 }
             }
 
-            return RA;
+            return R;
         }
 };
 
@@ -40,6 +40,8 @@ THE SOFTWARE.
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/detail/galerkin.hpp>
 #include <amgcl/coarsening/tentative_prolongation.hpp>
+#include <amgcl/coarsening/detail/aggregates.hpp>
+#include <amgcl/coarsening/detail/truncate.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -83,18 +85,63 @@ struct smoothed_aggregation {
          */
         float relax;
 
-        params() : relax(0.666f) { }
+        /// Number of the first levels that use aggressive coarsening.
+        /**
+         * \copydetails amgcl::coarsening::aggregation::params::aggressive_levels
+         */
+        unsigned aggressive_levels;
+
+        /// Truncation parameter for the prolongation operator.
+        /**
+         * Entries of the smoothed prolongation that are smaller (in absolute
+         * value) than the largest entry of the row by a factor of eps_trunc
+         * are dropped, and the remaining entries of the row are rescaled so
+         * that the row sum is preserved. Zero value disables the truncation.
+         */
+        float eps_trunc;
+
+        /// Maximum number of nonzero entries per row of the prolongation.
+        /**
+         * When positive, only trunc_max_nnz largest entries of each row of
+         * the smoothed prolongation are kept (with the same row sum
+         * rescaling as for eps_trunc). Zero value means no limit.
+         */
+        unsigned trunc_max_nnz;
+
+        /// Filtering parameter for the coarse operators.
+        /**
+         * Off-diagonal entries of the Galerkin operator with \f$|a_{ij}| <
+         * \varepsilon \sqrt{|a_{ii} a_{jj}|}\f$ are dropped and added to the
+         * diagonal. This keeps the stencil growth in check on deep
+         * hierarchies. Values around 0.01--0.02 are recommended, since too
+         * aggressive filtering may make the coarse operators singular. Zero
+         * value disables the filtering.
+         */
+        float eps_filter;
+
+        params()
+            : relax(0.666f), aggressive_levels(0),
+              eps_trunc(0), trunc_max_nnz(0), eps_filter(0)
+        { }
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_CHILD(p, aggr),
               AMGCL_PARAMS_IMPORT_CHILD(p, nullspace),
-              AMGCL_PARAMS_IMPORT_VALUE(p, relax)
+              AMGCL_PARAMS_IMPORT_VALUE(p, relax),
+              AMGCL_PARAMS_IMPORT_VALUE(p, aggressive_levels),
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, trunc_max_nnz),
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_filter)
         { }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_CHILD(p, path, aggr);
             AMGCL_PARAMS_EXPORT_CHILD(p, path, nullspace);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, relax);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, aggressive_levels);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_trunc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, trunc_max_nnz);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_filter);
         }
     };
 
@@ -109,6 +156,12 @@ struct smoothed_aggregation {
 
         TIC("aggregates");
         Aggregates aggr(A, prm.aggr);
+
+        if (prm.aggressive_levels > 0) {
+            --prm.aggressive_levels;
+            detail::aggregate_aggregates(A, prm.aggr, aggr);
+        }
+        detail::coarse_aggregates_params<Aggregates>::apply(prm.aggr, aggr);
         prm.aggr.eps_strong *= 0.5;
         TOC("aggregates");
 
@@ -209,6 +262,9 @@ struct smoothed_aggregation {
                 }
             }
         }
+
+        if (prm.eps_trunc > 0 || prm.trunc_max_nnz > 0)
+            detail::truncate(*P, prm.eps_trunc, prm.trunc_max_nnz);
         TOC("interpolation");
 
         boost::shared_ptr<Matrix> R = boost::make_shared<Matrix>();
@@ -224,10 +280,14 @@ struct smoothed_aggregation {
             const Matrix &A,
             const Matrix &P,
             const Matrix &R,
-            const params&
+            const params &prm
             )
     {
-        return detail::galerkin(A, P, R);
+        boost::shared_ptr<Matrix> Ac = detail::galerkin(A, P, R);
+
+        if (prm.eps_filter > 0) detail::filter(*Ac, prm.eps_filter);
+
+        return Ac;
     }
 };
 
@@ -34,31 +34,19 @@ THE SOFTWARE.
 #include <vector>
 #include <algorithm>
 
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
-#include <boost/iterator/counting_iterator.hpp>
-#include <boost/range/algorithm.hpp>
+#include <boost/range/numeric.hpp>
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/detail/qr.hpp>
 
 namespace amgcl {
 namespace coarsening {
-namespace detail {
-    struct skip_negative {
-        const std::vector<ptrdiff_t> &key;
-
-        skip_negative(const std::vector<ptrdiff_t> &key) : key(key) { }
-
-        bool operator()(ptrdiff_t i, ptrdiff_t j) const {
-            // Cast to unsigned type to keep negative values at the end
-            return
-                static_cast<size_t>(key[i]) <
-                static_cast<size_t>(key[j]);
-        }
-    };
-} // namespace detail
-
 
 //---------------------------------------------------------------------------
 struct nullspace_params {
@@ -111,13 +99,19 @@ struct nullspace_params {
  * If near nullspace vectors are not provided, returns piecewise-constant
  * prolongation operator. If user provides near nullspace vectors, those are
  * used to improve the prolongation operator.
+ *
+ * Aggregates are processed in parallel. The fine points are grouped by
+ * aggregate with a stable parallel counting sort, and the offsets of each
+ * aggregate in the prolongation operator and in the coarse nullspace are known
+ * in advance, so the result does not depend on the number of threads.
+ *
  * \see \cite Vanek2001
  */
 template <class Matrix>
 boost::shared_ptr<Matrix> tentative_prolongation(
         size_t n,
         size_t naggr,
-        const std::vector<ptrdiff_t> aggr,
+        const std::vector<ptrdiff_t> &aggr,
         nullspace_params &nullspace
         )
 {
@@ -127,81 +121,148 @@ boost::shared_ptr<Matrix> tentative_prolongation(
 
     TIC("tentative");
     if (nullspace.cols > 0) {
-        // Sort fine points by aggregate number.
-        // Put points not belonging to any aggregate to the end of the list.
-        std::vector<ptrdiff_t> order(
-                boost::counting_iterator<ptrdiff_t>(0),
-                boost::counting_iterator<ptrdiff_t>(n)
-                );
-        boost::sort(order, detail::skip_negative(aggr));
+        const ptrdiff_t nrows = n;
+        const ptrdiff_t na    = naggr;
+        const int       nc    = nullspace.cols;
+
+        // Sort fine points by aggregate number (stable counting sort).
+        // Points not belonging to any aggregate are skipped.
+        std::vector<ptrdiff_t> aggr_ptr(na + 1, 0);
+        std::vector<ptrdiff_t> order;
+
+#ifdef _OPENMP
+        const int nt = omp_get_max_threads();
+#else
+        const int nt = 1;
+#endif
+
+        // Each thread counts the points of its own chunk of rows.
+        std::vector<ptrdiff_t> cnt(nt * na, 0);
+
+#pragma omp parallel num_threads(nt)
+        {
+#ifdef _OPENMP
+            const int tid = omp_get_thread_num();
+            const int nth = omp_get_num_threads();
+#else
+            const int tid = 0;
+            const int nth = 1;
+#endif
+            ptrdiff_t chunk = (nrows + nth - 1) / nth;
+            ptrdiff_t beg   = std::min(tid * chunk, nrows);
+            ptrdiff_t end   = std::min(beg + chunk, nrows);
+
+            ptrdiff_t *my_cnt = &cnt[tid * na];
+
+            for(ptrdiff_t i = beg; i < end; ++i)
+                if (aggr[i] >= 0) ++my_cnt[aggr[i]];
+
+#pragma omp barrier
+
+            // Aggregate sizes, and the starting position of each thread
+            // inside every aggregate.
+#pragma omp for
+            for(ptrdiff_t a = 0; a < na; ++a) {
+                ptrdiff_t s = 0;
+                for(int t = 0; t < nth; ++t) {
+                    ptrdiff_t c = cnt[t * na + a];
+                    cnt[t * na + a] = s;
+                    s += c;
+                }
+                aggr_ptr[a + 1] = s;
+            }
+
+#pragma omp single
+            {
+                boost::partial_sum(aggr_ptr, aggr_ptr.begin());
+                order.resize(aggr_ptr.back());
+            }
+
+            for(ptrdiff_t i = beg; i < end; ++i) {
+                ptrdiff_t a = aggr[i];
+                if (a >= 0) order[aggr_ptr[a] + my_cnt[a]++] = i;
+            }
+        }
 
         // Precompute the shape of the prolongation operator.
         // Each row contains exactly nullspace.cols non-zero entries.
         // Rows that do not belong to any aggregate are empty.
         P->nrows = n;
-        P->ncols = naggr * nullspace.cols;
-        P->ptr.reserve(n + 1);
-
-        P->ptr.push_back(0);
-        for(size_t i = 0; i < n; ++i) {
-            if (aggr[i] < 0)
-                P->ptr.push_back(P->ptr.back());
-            else
-                P->ptr.push_back(P->ptr.back() + nullspace.cols);
-        }
+        P->ncols = naggr * nc;
+        P->ptr.resize(n + 1);
+        P->ptr[0] = 0;
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < nrows; ++i)
+            P->ptr[i+1] = aggr[i] < 0 ? 0 : nc;
+
+        boost::partial_sum(P->ptr, P->ptr.begin());
 
         P->col.resize(P->ptr.back());
         P->val.resize(P->ptr.back());
 
         // Compute the tentative prolongation operator and null-space vectors
-        // for the coarser level.
-        std::vector<double> Bnew;
-        Bnew.reserve(naggr * nullspace.cols * nullspace.cols);
-
-        size_t offset = 0;
-
-        amgcl::detail::QR<double> qr;
-        std::vector<double> Bpart;
-        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(naggr); ++i) {
-            int d = 0;
-            Bpart.clear();
-            for(size_t j = offset; j < n && aggr[order[j]] == i; ++j, ++d)
-                std::copy(
-                        &nullspace.B[nullspace.cols * order[j]],
-                        &nullspace.B[nullspace.cols * order[j]] + nullspace.cols,
-                        std::back_inserter(Bpart)
-                        );
-
-            qr.compute(d, nullspace.cols, Bpart.data());
-
-            for(int ii = 0; ii < nullspace.cols; ++ii)
-                for(int jj = 0; jj < nullspace.cols; ++jj)
-                    Bnew.push_back( qr.R(ii,jj) );
-
-            for(int ii = 0; ii < d; ++ii, ++offset) {
-                ptrdiff_t  *c = &P->col[P->ptr[order[offset]]];
-                value_type *v = &P->val[P->ptr[order[offset]]];
-
-                for(int jj = 0; jj < nullspace.cols; ++jj) {
-                    c[jj] = i * nullspace.cols + jj;
-                    v[jj] = qr.Q(ii,jj);
+        // for the coarser level. Aggregate i owns the block of nc x nc
+        // values in Bnew starting at i * nc * nc.
+        std::vector<double> Bnew(naggr * nc * nc);
+
+#pragma omp parallel
+        {
+            amgcl::detail::QR<double> qr;
+            std::vector<double> Bpart;
+
+#pragma omp for schedule(dynamic, 64)
+            for(ptrdiff_t i = 0; i < na; ++i) {
+                const ptrdiff_t beg = aggr_ptr[i];
+                const int       d   = aggr_ptr[i+1] - beg;
+
+                Bpart.resize(d * nc);
+
+                for(int ii = 0; ii < d; ++ii) {
+                    const double *b = &nullspace.B[nc * order[beg + ii]];
+                    std::copy(b, b + nc, &Bpart[ii * nc]);
+                }
+
+                qr.compute(d, nc, Bpart.data());
+
+                double *r = &Bnew[i * nc * nc];
+                for(int ii = 0; ii < nc; ++ii)
+                    for(int jj = 0; jj < nc; ++jj)
+                        *r++ = qr.R(ii,jj);
+
+                for(int ii = 0; ii < d; ++ii) {
+                    ptrdiff_t  *c = &P->col[P->ptr[order[beg + ii]]];
+                    value_type *v = &P->val[P->ptr[order[beg + ii]]];
+
+                    for(int jj = 0; jj < nc; ++jj) {
+                        c[jj] = i * nc + jj;
+                        v[jj] = qr.Q(ii,jj);
+                    }
                 }
             }
         }
 
         std::swap(nullspace.B, Bnew);
     } else {
+        const ptrdiff_t nrows = n;
+
         P->nrows = n;
         P->ncols = naggr;
-        P->ptr.reserve(n + 1);
-        P->col.reserve(n);
+        P->ptr.resize(n + 1);
+        P->ptr[0] = 0;
 
-        P->ptr.push_back(0);
-        for(size_t i = 0; i < n; ++i) {
-            if (aggr[i] >= 0) P->col.push_back(aggr[i]);
-            P->ptr.push_back( static_cast<ptrdiff_t>(P->col.size()) );
-        }
-        P->val.resize(n, static_cast<value_type>(1));
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < nrows; ++i)
+            P->ptr[i+1] = aggr[i] < 0 ? 0 : 1;
+
+        boost::partial_sum(P->ptr, P->ptr.begin());
+
+        P->col.resize(P->ptr.back());
+        P->val.resize(P->ptr.back(), static_cast<value_type>(1));
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < nrows; ++i)
+            if (aggr[i] >= 0) P->col[P->ptr[i]] = aggr[i];
     }
     TOC("tentative");
 
@@ -0,0 +1,401 @@
+#ifndef AMGCL_DETAIL_DECOUPLED_ROWS_HPP
+#define AMGCL_DETAIL_DECOUPLED_ROWS_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/detail/decoupled_rows.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Elimination of decoupled (e.g. Dirichlet) rows from the system.
+ */
+
+#include <vector>
+#include <cmath>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/range/numeric.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace detail {
+
+template <class Backend>
+class decoupled_rows;
+
+/// Reduced system matrix as an operator.
+/** \sa decoupled_rows::reduced() */
+template <class Backend, class Matrix>
+struct reduced_operator {
+    typedef typename Backend::value_type value_type;
+
+    const decoupled_rows<Backend> &E;
+    const Matrix &A;
+
+    reduced_operator(const decoupled_rows<Backend> &E, const Matrix &A)
+        : E(E), A(A) {}
+};
+
+/// Elimination of decoupled rows from the system.
+/**
+ * Row \f$i\f$ is decoupled when \f$|a_{ij}| \le \varepsilon |a_{ii}|\f$ for
+ * all \f$j \neq i\f$. This is the case for the identity rows that result
+ * from Dirichlet conditions. The unknowns of the decoupled rows are
+ * eliminated: \f$x_i = b_i / a_{ii}\f$, and their contributions are moved to
+ * the right-hand side of the remaining rows. The reduced system is then used
+ * for the hierarchy setup and for the iterative solution, so that the
+ * decoupled rows do not take part in any of the per-iteration operations.
+ *
+ * The restriction of the right-hand side and the expansion of the solution
+ * are done with sparse matrix-vector products, so any backend is supported.
+ * A new system matrix with the same decoupled rows may be applied in the
+ * reduced space with reduced(), without any host-side conversion.
+ * With the default \f$\varepsilon = 0\f$ the elimination is exact. For
+ * \f$\varepsilon > 0\f$ the weak couplings of the eliminated rows are
+ * neglected, and the solution becomes approximate.
+ */
+template <class Backend>
+class decoupled_rows {
+    public:
+        typedef typename Backend::value_type value_type;
+        typedef typename Backend::matrix     matrix;
+        typedef typename Backend::vector     vector;
+        typedef typename Backend::params     backend_params;
+
+        typedef typename backend::builtin<value_type>::matrix build_matrix;
+
+        /// Elimination parameters.
+        struct params {
+            /// Eliminate the decoupled rows.
+            bool enable;
+
+            /// Relative threshold for the couplings of the decoupled rows.
+            float eps;
+
+            params() : enable(false), eps(0) {}
+
+            params(const boost::property_tree::ptree &p)
+                : AMGCL_PARAMS_IMPORT_VALUE(p, enable),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, eps)
+            {}
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, enable);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, eps);
+            }
+        };
+
+        /// Finds the decoupled rows of the matrix and builds the reduced system.
+        template <class Matrix>
+        decoupled_rows(const Matrix &M, const params &prm, const backend_params &bprm)
+            : n(backend::rows(M)), nr(0)
+        {
+            build_matrix A(M);
+
+            std::vector<ptrdiff_t>  idx(n + 1, 0);
+            std::vector<value_type> dinv(n, 0);
+
+            // Find the decoupled rows.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                value_type d = 0, s = 0;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    if (A.col[j] == i)
+                        d += A.val[j];
+                    else
+                        s = std::max(s, static_cast<value_type>(std::abs(A.val[j])));
+                }
+
+                if (d != 0 && s <= prm.eps * std::abs(d))
+                    dinv[i] = 1 / d;
+                else
+                    idx[i + 1] = 1;
+            }
+
+            boost::partial_sum(idx, idx.begin());
+            nr = idx.back();
+
+            if (nr == n) return;
+
+            precondition(nr > 0, "All rows of the matrix are decoupled");
+
+            // Reduced index of each kept row, -1 for the decoupled ones.
+            std::vector<ptrdiff_t> id(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                id[i] = (idx[i + 1] > idx[i]) ? idx[i] : -1;
+
+            Ar = boost::make_shared<build_matrix>();
+            boost::shared_ptr<build_matrix> R  = boost::make_shared<build_matrix>();
+            boost::shared_ptr<build_matrix> E  = boost::make_shared<build_matrix>();
+            boost::shared_ptr<build_matrix> Et = boost::make_shared<build_matrix>();
+            boost::shared_ptr<build_matrix> D  = boost::make_shared<build_matrix>();
+
+            Ar->nrows = Ar->ncols = nr;
+            R->nrows  = nr; R->ncols  = n;
+            E->nrows  = nr; E->ncols  = n;
+            Et->nrows = n;  Et->ncols = nr;
+            D->nrows  = n;  D->ncols  = n;
+
+            Ar->ptr.resize(nr + 1, 0);
+            R->ptr.resize(nr + 1, 0);
+            E->ptr.resize(nr + 1, 0);
+            Et->ptr.resize(n + 1, 0);
+            D->ptr.resize(n + 1, 0);
+
+            // Count the nonzeros. The rows of R contain the unit diagonal
+            // and the couplings to the decoupled unknowns.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t r = id[i];
+
+                if (r < 0) {
+                    D->ptr[i + 1] = 1;
+                    continue;
+                }
+
+                Et->ptr[i + 1] = 1;
+                E->ptr[r + 1]  = 1;
+
+                ptrdiff_t na = 0, nd = 1;
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    if (id[A.col[j]] < 0) ++nd; else ++na;
+                }
+
+                Ar->ptr[r + 1] = na;
+                R->ptr[r + 1]  = nd;
+            }
+
+            boost::partial_sum(Ar->ptr, Ar->ptr.begin());
+            boost::partial_sum(R->ptr,  R->ptr.begin());
+            boost::partial_sum(E->ptr,  E->ptr.begin());
+            boost::partial_sum(Et->ptr, Et->ptr.begin());
+            boost::partial_sum(D->ptr,  D->ptr.begin());
+
+            Ar->col.resize(Ar->ptr.back()); Ar->val.resize(Ar->ptr.back());
+            R->col.resize(R->ptr.back());   R->val.resize(R->ptr.back());
+            E->col.resize(E->ptr.back());   E->val.resize(E->ptr.back());
+            Et->col.resize(Et->ptr.back()); Et->val.resize(Et->ptr.back());
+            D->col.resize(D->ptr.back());   D->val.resize(D->ptr.back());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t r = id[i];
+
+                if (r < 0) {
+                    ptrdiff_t h = D->ptr[i];
+                    D->col[h] = i;
+                    D->val[h] = dinv[i];
+                    continue;
+                }
+
+                Et->col[Et->ptr[i]] = r;
+                Et->val[Et->ptr[i]] = 1;
+
+                E->col[E->ptr[r]] = i;
+                E->val[E->ptr[r]] = 1;
+
+                ptrdiff_t ha = Ar->ptr[r];
+                ptrdiff_t hr = R->ptr[r];
+
+                R->col[hr] = i;
+                R->val[hr] = 1;
+                ++hr;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    ptrdiff_t k = id[c];
+
+                    if (k < 0) {
+                        R->col[hr] = c;
+                        R->val[hr] = -A.val[j] * dinv[c];
+                        ++hr;
+                    } else {
+                        Ar->col[ha] = k;
+                        Ar->val[ha] = A.val[j];
+                        ++ha;
+                    }
+                }
+            }
+
+            this->R  = Backend::copy_matrix(R,  bprm);
+            this->E  = Backend::copy_matrix(E,  bprm);
+            this->Et = Backend::copy_matrix(Et, bprm);
+            this->D  = Backend::copy_matrix(D,  bprm);
+
+            f = Backend::create_vector(nr, bprm);
+            u = Backend::create_vector(nr, bprm);
+            t = Backend::create_vector(n,  bprm);
+            q = Backend::create_vector(n,  bprm);
+        }
+
+        /// Returns true if any rows were eliminated.
+        bool active() const {
+            return nr < n;
+        }
+
+        /// Size of the reduced system.
+        size_t size() const {
+            return nr;
+        }
+
+        /// The reduced system matrix.
+        /**
+         * The matrix is only needed for the hierarchy setup and may be
+         * released afterwards with release().
+         */
+        const build_matrix& system_matrix() const {
+            return *Ar;
+        }
+
+        /// Releases the reduced system matrix.
+        void release() {
+            Ar.reset();
+        }
+
+        /// Restricts the right-hand side and the initial approximation to
+        /// the reduced system.
+        template <class Vec1, class Vec2>
+        void reduce(const Vec1 &rhs, const Vec2 &x) const {
+            backend::spmv(1, *R, rhs, 0, *f);
+            backend::spmv(1, *E, x,   0, *u);
+        }
+
+        /// Restricts the right-hand side and the initial approximation to
+        /// the reduced system of the given matrix.
+        /**
+         * The matrix should have the same decoupled rows as the one the
+         * elimination was built for. The couplings to the eliminated
+         * unknowns are taken from the new matrix.
+         */
+        template <class Matrix, class Vec1, class Vec2>
+        void reduce(const Matrix &A, const Vec1 &rhs, const Vec2 &x) const {
+            backend::spmv(1, *D, rhs, 0, *t);
+            backend::residual(rhs, A, *t, *q);
+            backend::spmv(1, *E, *q, 0, *f);
+            backend::spmv(1, *E, x,  0, *u);
+        }
+
+        /// Returns the reduced system of the given matrix as an operator.
+        /**
+         * The operator is applied with backend::spmv() and
+         * backend::residual() as \f$E A E^T\f$, where \f$E\f$ selects the
+         * kept unknowns.
+         */
+        template <class Matrix>
+        reduced_operator<Backend, Matrix> reduced(const Matrix &A) const {
+            return reduced_operator<Backend, Matrix>(*this, A);
+        }
+
+        /// Computes \f$y = \alpha E A E^T x + \beta y\f$.
+        template <class Matrix, class Vec1, class Vec2>
+        void spmv(value_type alpha, const Matrix &A, const Vec1 &x,
+                value_type beta, Vec2 &y) const
+        {
+            backend::spmv(1, *Et, x, 0, *t);
+            backend::spmv(1, A, *t, 0, *q);
+            backend::spmv(alpha, *E, *q, beta, y);
+        }
+
+        /// Computes \f$r = rhs - E A E^T x\f$.
+        template <class Matrix, class Vec1, class Vec2, class Vec3>
+        void residual(const Vec1 &rhs, const Matrix &A, const Vec2 &x,
+                Vec3 &r) const
+        {
+            backend::spmv(1, *Et, x, 0, *t);
+            backend::spmv(1, A, *t, 0, *q);
+            backend::copy(rhs, r);
+            backend::spmv(-1, *E, *q, 1, r);
+        }
+
+        /// Expands the solution of the reduced system to the full one.
+        template <class Vec1, class Vec2>
+        void expand(const Vec1 &rhs, Vec2 &x) const {
+            backend::spmv(1, *D,  rhs, 0, x);
+            backend::spmv(1, *Et, *u,  1, x);
+        }
+
+        /// The right-hand side of the reduced system.
+        vector& rhs() const {
+            return *f;
+        }
+
+        /// The solution of the reduced system.
+        vector& x() const {
+            return *u;
+        }
+
+    private:
+        ptrdiff_t n, nr;
+
+        boost::shared_ptr<build_matrix> Ar;
+
+        // R maps the right-hand side to the reduced one, E and Et select the
+        // kept unknowns, and D solves for the eliminated ones.
+        boost::shared_ptr<matrix> R, E, Et, D;
+
+        boost::shared_ptr<vector> f, u;
+
+        // Full-size temporaries for the operations with a new matrix.
+        boost::shared_ptr<vector> t, q;
+};
+
+} // namespace detail
+
+namespace backend {
+
+template <class B, class M, class V1, class V2>
+struct spmv_impl< amgcl::detail::reduced_operator<B, M>, V1, V2 >
+{
+    typedef amgcl::detail::reduced_operator<B, M> Op;
+    typedef typename B::value_type value_type;
+
+    static void apply(value_type alpha, const Op &A, const V1 &x,
+            value_type beta, V2 &y)
+    {
+        A.E.spmv(alpha, A.A, x, beta, y);
+    }
+};
+
+template <class B, class M, class V1, class V2, class V3>
+struct residual_impl< amgcl::detail::reduced_operator<B, M>, V1, V2, V3 >
+{
+    typedef amgcl::detail::reduced_operator<B, M> Op;
+
+    static void apply(const V1 &rhs, const Op &A, const V2 &x, V3 &r)
+    {
+        A.E.residual(rhs, A.A, x, r);
+    }
+};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
@@ -38,8 +38,20 @@ THE SOFTWARE.
 namespace amgcl {
 namespace detail {
 
+/// Storage order of the matrix to decompose.
+enum storage_order {
+    row_major,
+    col_major
+};
+
 /// In-place QR decomposition.
-template <typename value_type>
+/**
+ * With column-major storage the Householder reflections sweep over contiguous
+ * memory, which is noticeably faster for tall matrices. The internal buffers
+ * only grow, so the same instance may be reused for a sequence of small
+ * decompositions without heap reallocations.
+ */
+template <typename value_type, storage_order order = row_major>
 class QR {
     public:
         QR() : m(0), n(0) {}
@@ -61,16 +73,16 @@ class QR {
 
             for(size_t j = 0; j < n; ++j) {
                 value_type s = 0;
-                for(size_t i = j; i < m; ++i) s += r[i*n+j] * r[i*n+j];
+                for(size_t i = j; i < m; ++i) s += r[idx(i, j)] * r[idx(i, j)];
                 s = sqrt(s);
-                d[j] = r[j*n+j] > 0 ? -s : s;
-                value_type fak = sqrt(s * (s + fabs(r[j*n+j])));
-                r[j*n+j] -= d[j];
-                for(size_t k = j; k < m; ++k) r[k*n+j] /= fak;
+                d[j] = r[idx(j, j)] > 0 ? -s : s;
+                value_type fak = sqrt(s * (s + fabs(r[idx(j, j)])));
+                r[idx(j, j)] -= d[j];
+                for(size_t k = j; k < m; ++k) r[idx(k, j)] /= fak;
                 for(size_t i = j + 1; i < n; ++i) {
                     value_type s = 0;
-                    for(size_t k = j; k < m; ++k) s += r[k*n+j] * r[k*n+i];
-                    for(size_t k = j; k < m; ++k) r[k*n+i] -= r[k*n+j] * s;
+                    for(size_t k = j; k < m; ++k) s += r[idx(k, j)] * r[idx(k, i)];
+                    for(size_t k = j; k < m; ++k) r[idx(k, i)] -= r[idx(k, j)] * s;
                 }
             }
 
@@ -84,8 +96,8 @@ class QR {
                     for(size_t j = n; j-- > 0; ) {
                         value_type s = 0;
 
-                        for(size_t k = j; k < m; ++k) s += r[k*n+j] * q[k*n+i];
-                        for(size_t k = j; k < m; ++k) q[k*n+i] -= r[k*n+j] * s;
+                        for(size_t k = j; k < m; ++k) s += r[idx(k, j)] * q[k*n+i];
+                        for(size_t k = j; k < m; ++k) q[k*n+i] -= r[idx(k, j)] * s;
                     }
                 }
             }
@@ -97,7 +109,7 @@ class QR {
             if (i == j)
                 return sign * d[i];
             else
-                return sign * r[i*n+j];
+                return sign * r[idx(i, j)];
         }
 
         value_type Q(size_t i, size_t j) const {
@@ -109,14 +121,14 @@ class QR {
             for(size_t j = 0; j < n; ++j) {
                 value_type s = 0;
 
-                for(size_t k = j; k < m; ++k) s += r[k*n+j] * f[k];
-                for(size_t k = j; k < m; ++k) f[k] -= r[k*n+j] * s;
+                for(size_t k = j; k < m; ++k) s += r[idx(k, j)] * f[k];
+                for(size_t k = j; k < m; ++k) f[k] -= r[idx(k, j)] * s;
             }
 
             // x = R^-1 x
             for (size_t i = n; i --> 0; ) {
                 value_type sum = x[i] = f[i];
-                for (size_t j = i + 1; j < n; j++) sum -= r[i*n+j] * x[j];
+                for (size_t j = i + 1; j < n; j++) sum -= r[idx(i, j)] * x[j];
                 x[i] = sum / d[i];
             }
         }
@@ -129,6 +141,10 @@ class QR {
         std::vector<value_type> d;
         std::vector<value_type> q;
 
+        size_t idx(size_t i, size_t j) const {
+            return order == row_major ? i * n + j : j * m + i;
+        }
+
         void resize(std::vector<value_type> &v, size_t size) {
             if (v.size() < size) v.resize(size);
         }
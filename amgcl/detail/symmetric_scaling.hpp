@@ -0,0 +1,344 @@
+#ifndef AMGCL_DETAIL_SYMMETRIC_SCALING_HPP
+#define AMGCL_DETAIL_SYMMETRIC_SCALING_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/detail/symmetric_scaling.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Symmetric diagonal scaling of the system matrix.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace detail {
+
+/// Kinds of symmetric scaling.
+namespace scaling {
+enum type {
+    none,   ///< No scaling.
+    jacobi, ///< Scaling by the diagonal.
+    ruiz    ///< Ruiz equilibration.
+};
+
+inline std::ostream& operator<<(std::ostream &os, type s) {
+    switch (s) {
+        case none:
+            return os << "none";
+        case jacobi:
+            return os << "jacobi";
+        case ruiz:
+            return os << "ruiz";
+        default:
+            return os << "???";
+    }
+}
+
+inline std::istream& operator>>(std::istream &in, type &s)
+{
+    std::string val;
+    in >> val;
+
+    if (val == "none")
+        s = none;
+    else if (val == "jacobi")
+        s = jacobi;
+    else if (val == "ruiz")
+        s = ruiz;
+    else
+        throw std::invalid_argument("Invalid scaling value");
+
+    return in;
+}
+
+} // namespace scaling
+
+template <class Backend>
+class symmetric_scaling;
+
+/// Scaled system matrix as an operator.
+/** \sa symmetric_scaling::scaled() */
+template <class Backend, class Matrix>
+struct scaled_operator {
+    typedef typename Backend::value_type value_type;
+
+    const symmetric_scaling<Backend> &Q;
+    const Matrix &A;
+
+    scaled_operator(const symmetric_scaling<Backend> &Q, const Matrix &A)
+        : Q(Q), A(A) {}
+};
+
+/// Symmetric diagonal scaling of the system.
+/**
+ * Replaces the system \f$Ax = b\f$ with \f$(DAD)y = Db\f$, \f$x = Dy\f$,
+ * where \f$D\f$ is a positive diagonal matrix. The jacobi scaling uses
+ * \f$d_i = |a_{ii}|^{-1/2}\f$, so that the scaled matrix has unit diagonal.
+ * The ruiz scaling iteratively divides each row and column by the square
+ * root of the maximum absolute value of its row, until the row maxima of the
+ * scaled matrix are close to one. For nonsymmetric matrices only the row
+ * maxima are equilibrated, since the same factor is applied to the row and
+ * the column.
+ *
+ * The scaling of the right-hand side and of the solution is done with
+ * backend::vmul(), so any backend is supported. A new system matrix may be
+ * applied in the scaled space with scaled(), without any host-side
+ * conversion.
+ */
+template <class Backend>
+class symmetric_scaling {
+    public:
+        typedef typename Backend::value_type value_type;
+        typedef typename Backend::vector     vector;
+        typedef typename Backend::params     backend_params;
+
+        typedef typename backend::builtin<value_type>::matrix build_matrix;
+
+        /// Scaling parameters.
+        struct params {
+            /// Kind of the scaling.
+            scaling::type type;
+
+            /// Maximum number of ruiz iterations.
+            unsigned maxiter;
+
+            /// Tolerance for the row maxima of the ruiz scaling.
+            float tol;
+
+            params() : type(scaling::none), maxiter(10), tol(0.1f) {}
+
+            params(const boost::property_tree::ptree &p)
+                : AMGCL_PARAMS_IMPORT_VALUE(p, type),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, maxiter),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, tol)
+            {}
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, type);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, maxiter);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, tol);
+            }
+        };
+
+        /// Computes the scaling for the matrix.
+        template <class Matrix>
+        symmetric_scaling(const Matrix &A, const params &prm, const backend_params &bprm)
+            : n(backend::rows(A))
+        {
+            build_matrix M(A);
+
+            std::vector<value_type> d(n, 1);
+
+            if (prm.type == scaling::jacobi) {
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    for(ptrdiff_t j = M.ptr[i], e = M.ptr[i+1]; j < e; ++j) {
+                        if (M.col[j] == i) {
+                            value_type v = std::abs(M.val[j]);
+                            if (v > 0) d[i] = 1 / std::sqrt(v);
+                            break;
+                        }
+                    }
+                }
+            } else if (prm.type == scaling::ruiz) {
+                std::vector<value_type> r(n);
+
+                for(unsigned k = 0; k < prm.maxiter; ++k) {
+                    value_type eps = 0;
+
+#pragma omp parallel
+                    {
+                        value_type my_eps = 0;
+
+#pragma omp for
+                        for(ptrdiff_t i = 0; i < n; ++i) {
+                            value_type s = 0;
+                            for(ptrdiff_t j = M.ptr[i], e = M.ptr[i+1]; j < e; ++j)
+                                s = std::max(s, d[i] * d[M.col[j]] * std::abs(M.val[j]));
+
+                            r[i] = s;
+                            if (s > 0) my_eps = std::max(my_eps, std::abs(1 - s));
+                        }
+
+#pragma omp critical
+                        eps = std::max(eps, my_eps);
+                    }
+
+                    if (eps <= prm.tol) break;
+
+#pragma omp parallel for
+                    for(ptrdiff_t i = 0; i < n; ++i)
+                        if (r[i] > 0) d[i] /= std::sqrt(r[i]);
+                }
+            }
+
+            D    = Backend::copy_vector(d, bprm);
+            f    = Backend::create_vector(n, bprm);
+            u    = Backend::create_vector(n, bprm);
+            t    = Backend::create_vector(n, bprm);
+            q    = Backend::create_vector(n, bprm);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) d[i] = 1 / d[i];
+
+            Dinv = Backend::copy_vector(d, bprm);
+
+            this->d.swap(d);
+        }
+
+        /// Size of the system.
+        size_t size() const {
+            return n;
+        }
+
+        /// Returns the scaled matrix \f$DAD\f$.
+        template <class Matrix>
+        boost::shared_ptr<build_matrix> scaled_matrix(const Matrix &A) const {
+            precondition(
+                    static_cast<ptrdiff_t>(backend::rows(A)) == n,
+                    "Matrix size does not match the scaling"
+                    );
+
+            boost::shared_ptr<build_matrix> M = boost::make_shared<build_matrix>(A);
+
+            // d holds the inverse of the scaling.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                for(ptrdiff_t j = M->ptr[i], e = M->ptr[i+1]; j < e; ++j)
+                    M->val[j] = M->val[j] / (d[i] * d[M->col[j]]);
+
+            return M;
+        }
+
+        /// Returns the scaled system of the given matrix as an operator.
+        /**
+         * The operator is applied with backend::spmv() and
+         * backend::residual() as \f$DAD\f$.
+         */
+        template <class Matrix>
+        scaled_operator<Backend, Matrix> scaled(const Matrix &A) const {
+            return scaled_operator<Backend, Matrix>(*this, A);
+        }
+
+        /// Computes \f$y = \alpha DAD x + \beta y\f$.
+        template <class Matrix, class Vec1, class Vec2>
+        void spmv(value_type alpha, const Matrix &A, const Vec1 &x,
+                value_type beta, Vec2 &y) const
+        {
+            backend::vmul(1, *D, x, 0, *t);
+            backend::spmv(1, A, *t, 0, *q);
+            backend::vmul(alpha, *D, *q, beta, y);
+        }
+
+        /// Computes \f$r = rhs - DAD x\f$.
+        template <class Matrix, class Vec1, class Vec2, class Vec3>
+        void residual(const Vec1 &rhs, const Matrix &A, const Vec2 &x,
+                Vec3 &r) const
+        {
+            backend::vmul(1, *D, x, 0, *t);
+            backend::spmv(1, A, *t, 0, *q);
+            backend::copy(rhs, r);
+            backend::vmul(-1, *D, *q, 1, r);
+        }
+
+        /// Scales the right-hand side and the initial approximation.
+        template <class Vec1, class Vec2>
+        void scale(const Vec1 &rhs, const Vec2 &x) const {
+            backend::vmul(1, *D,    rhs, 0, *f);
+            backend::vmul(1, *Dinv, x,   0, *u);
+        }
+
+        /// Recovers the solution of the original system.
+        template <class Vec>
+        void unscale(Vec &x) const {
+            backend::vmul(1, *D, *u, 0, x);
+        }
+
+        /// The right-hand side of the scaled system.
+        vector& rhs() const {
+            return *f;
+        }
+
+        /// The solution of the scaled system.
+        vector& x() const {
+            return *u;
+        }
+
+    private:
+        ptrdiff_t n;
+
+        // Inverse of the scaling.
+        std::vector<value_type> d;
+
+        boost::shared_ptr<vector> D, Dinv, f, u;
+
+        // Temporaries for the operations with a new matrix.
+        boost::shared_ptr<vector> t, q;
+};
+
+} // namespace detail
+
+namespace backend {
+
+template <class B, class M, class V1, class V2>
+struct spmv_impl< amgcl::detail::scaled_operator<B, M>, V1, V2 >
+{
+    typedef amgcl::detail::scaled_operator<B, M> Op;
+    typedef typename B::value_type value_type;
+
+    static void apply(value_type alpha, const Op &A, const V1 &x,
+            value_type beta, V2 &y)
+    {
+        A.Q.spmv(alpha, A.A, x, beta, y);
+    }
+};
+
+template <class B, class M, class V1, class V2, class V3>
+struct residual_impl< amgcl::detail::scaled_operator<B, M>, V1, V2, V3 >
+{
+    typedef amgcl::detail::scaled_operator<B, M> Op;
+
+    static void apply(const V1 &rhs, const Op &A, const V2 &x, V3 &r)
+    {
+        A.Q.residual(rhs, A.A, x, r);
+    }
+};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
@@ -266,6 +266,55 @@ inline void process_sdd(
                 amgcl::relaxation::chebyshev
                 >(iterative_solver, direct_solver, func);
             break;
+        case runtime::relaxation::parallel_ilu0:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::parallel_ilu0
+                >(iterative_solver, direct_solver, func);
+            break;
+        case runtime::relaxation::iluk:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::iluk
+                >(iterative_solver, direct_solver, func);
+            break;
+        case runtime::relaxation::ilut:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::ilut
+                >(iterative_solver, direct_solver, func);
+            break;
+        case runtime::relaxation::hybrid_gauss_seidel:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::hybrid_gauss_seidel
+                >(iterative_solver, direct_solver, func);
+            break;
+        case runtime::relaxation::l1_jacobi:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::l1_jacobi
+                >(iterative_solver, direct_solver, func);
+            break;
+        case runtime::relaxation::spai_threshold:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::spai_threshold
+                >(iterative_solver, direct_solver, func);
+            break;
+        case runtime::relaxation::per_level:
+            process_sdd<
+                Backend,
+                Coarsening,
+                amgcl::runtime::per_level_relaxation
+                >(iterative_solver, direct_solver, func);
+            break;
     }
 }
 
@@ -312,6 +361,14 @@ inline void process_sdd(
                     >
                 >(relaxation, iterative_solver, direct_solver, func);
             break;
+        case runtime::coarsening::pairwise_aggregation:
+            process_sdd<
+                Backend,
+                amgcl::coarsening::aggregation<
+                    amgcl::coarsening::pairwise_aggregates
+                    >
+                >(relaxation, iterative_solver, direct_solver, func);
+            break;
     }
 }
 
@@ -33,19 +33,122 @@ THE SOFTWARE.
 
 #include <vector>
 #include <cmath>
-#include <boost/range/iterator_range.hpp>
+#include <iostream>
 #include <boost/foreach.hpp>
-#include <boost/multi_array.hpp>
-#include <boost/math/constants/constants.hpp>
+#include <boost/type_traits.hpp>
+#include <boost/utility/enable_if.hpp>
 
-#include <amgcl/detail/inverse.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/relaxation/interface.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
 namespace relaxation {
+namespace detail {
+
+// Single step of Chebyshev iteration:
+//   r  = r - A d0
+//   d1 = c1 d0 + c2 M r
+//   x  = x + d1
+// where M is the optional inverted diagonal.
+template <class Matrix, class VecM, class VecR, class VecX, class Enable = void>
+struct chebyshev_step {
+    typedef typename backend::value_type<Matrix>::type V;
+
+    template <class VecD>
+    static void apply(V c1, V c2, const Matrix &A, const VecM *M,
+            VecR &r, const VecD &d0, VecD &d1, VecX &x)
+    {
+        backend::spmv(1, A, d0, 0, d1);
+        backend::axpby(-1, d1, 1, r);
+
+        if (M) {
+            backend::vmul(c2, *M, r, 0, d1);
+            backend::axpby(c1, d0, 1, d1);
+        } else {
+            backend::axpby(c2, r, 0, d1);
+            backend::axpby(c1, d0, 1, d1);
+        }
+
+        backend::axpby(1, d1, 1, x);
+    }
+};
+
+// The builtin backend does the whole step in a single sweep over the matrix.
+template <typename V, typename C, typename P, class VecM, class VecR, class VecX>
+struct chebyshev_step<
+    backend::crs<V, C, P>, VecM, VecR, VecX,
+    typename boost::enable_if<
+            typename boost::mpl::and_<
+                typename backend::is_builtin_vector<VecM>::type,
+                typename backend::is_builtin_vector<VecR>::type,
+                typename backend::is_builtin_vector<VecX>::type
+                >::type
+        >::type
+    >
+{
+    template <class VecD>
+    static void apply(V c1, V c2, const backend::crs<V, C, P> &A, const VecM *M,
+            VecR &r, const VecD &d0, VecD &d1, VecX &x)
+    {
+        const ptrdiff_t n = backend::rows(A);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            V s = 0;
+            for(P j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                s += A.val[j] * d0[A.col[j]];
+
+            V ri = r[i] - s;
+            V di = c1 * d0[i] + c2 * (M ? (*M)[i] * ri : ri);
+
+            r[i]   = ri;
+            d1[i]  = di;
+            x[i]  += di;
+        }
+    }
+};
+
+// Coefficients of the three-term recurrence for the Chebyshev polynomial of
+// the given degree on the interval [lo, hi]. Returns the scaling of the
+// first step (the interval center).
+template <typename V>
+V chebyshev_coefficients(V lo, V hi, unsigned degree,
+        std::vector< std::pair<V, V> > &C)
+{
+    V theta = (hi + lo) / 2;
+    V delta = (hi - lo) / 2;
+    V sigma = theta / delta;
+    V rho   = 1 / sigma;
+
+    C.clear();
+    for(unsigned k = 1; k < degree; ++k) {
+        V rho_new = 1 / (2 * sigma - rho);
+
+        C.push_back(std::make_pair(rho_new * rho, 2 * rho_new / delta));
+
+        rho = rho_new;
+    }
+
+    return theta;
+}
+
+} // namespace detail
 
 /// Chebyshev polynomial smoother.
 /**
+ * The smoother uses the three-term recurrence for Chebyshev polynomials
+ * \cite Adams2003. With the builtin backend each step of the recurrence is
+ * done in a single pass over the matrix and the work vectors.
+ *
+ * The polynomial is built on the interval [lower * eigmax, eigmax], where
+ * eigmax is an estimate of the spectral radius of the matrix (or of
+ * \f$D^{-1}A\f$, when \p scale is set). By default the Gershgorin bound is
+ * used. When \p lanczos_iters is nonzero, the estimate is obtained with the
+ * given number of Lanczos iterations and multiplied by the \p safety factor.
+ * This gives a much tighter estimate for symmetric matrices and usually
+ * allows to use lower polynomial degree.
+ *
  * \param Backend Backend for temporary structures allocation.
  * \ingroup relaxation
  */
@@ -63,16 +166,37 @@ class chebyshev {
             /// Lowest-to-highest eigen value ratio.
             float lower;
 
-            params() : degree(5), lower(1.0f / 30) {}
+            /// Number of Lanczos iterations for the spectral radius estimate.
+            /**
+             * When zero, the Gershgorin bound is used instead.
+             */
+            unsigned lanczos_iters;
+
+            /// Safety factor for the Lanczos estimate.
+            float safety;
+
+            /// Apply the polynomial to the Jacobi-preconditioned matrix.
+            bool scale;
+
+            params()
+                : degree(5), lower(1.0f / 30), lanczos_iters(0), safety(1.1f),
+                  scale(false)
+            {}
 
             params(const boost::property_tree::ptree &p)
                 : AMGCL_PARAMS_IMPORT_VALUE(p, degree),
-                  AMGCL_PARAMS_IMPORT_VALUE(p, lower)
+                  AMGCL_PARAMS_IMPORT_VALUE(p, lower),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, lanczos_iters),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, safety),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, scale)
             {}
 
             void get(boost::property_tree::ptree &p, const std::string &path) const {
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, degree);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, lower);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, lanczos_iters);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, safety);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, scale);
             }
         };
 
@@ -81,53 +205,22 @@ class chebyshev {
         chebyshev(
                 const Matrix &A, const params &prm,
                 const typename Backend::params &backend_prm
-            ) : C( prm.degree ),
-                p( Backend::create_vector(rows(A), backend_prm) ),
+            ) : p( Backend::create_vector(rows(A), backend_prm) ),
                 q( Backend::create_vector(rows(A), backend_prm) )
         {
             typedef value_type V;
 
-            V hi = spectral_radius(A);
-            V lo = hi * prm.lower;
-
-            // Chebyshev polynomial roots on the interval [lo, hi].
-            std::vector<value_type> roots(prm.degree);
-            for(unsigned i = 0; i < prm.degree; ++i) {
-                using boost::math::constants::pi;
-                using boost::math::constants::half;
-
-                roots[i] = lo + half<V>() * ( hi - lo ) * (
-                        1 + cos( pi<V>() * ( i + half<V>() ) / prm.degree )
-                        );
+            if (prm.scale) {
+                std::vector<value_type> dia = inverted_diagonal(A);
+                M = Backend::copy_vector(dia, backend_prm);
             }
 
-            // Construct linear system to determine Chebyshev coefficients.
-            boost::multi_array<V, 2> S(boost::extents[prm.degree][prm.degree]);
-            std::vector<V> rhs(prm.degree);
-            for(unsigned i = 0; i < prm.degree; ++i) {
-                V x = roots[i];
-                V x_to_j = 1;
-                for(unsigned j = 0; j < prm.degree; ++j) {
-                    S[i][j] = x_to_j;
-                    x_to_j *= x;
-                }
-                rhs[i] = -x_to_j;
-            }
+            if (prm.lanczos_iters)
+                emax = prm.safety * lanczos(A, prm.scale, prm.lanczos_iters);
+            else
+                emax = spectral_radius(A, prm.scale);
 
-            // Invert S, compute coefficients.
-            amgcl::detail::inverse(prm.degree, S.data());
-
-            value_type const_c = 1;
-            for(unsigned i = 0; i < prm.degree; ++i) {
-                value_type c = 0;
-                for(unsigned j = 0; j < prm.degree; ++j)
-                    c += S[i][j] * rhs[j];
-                if (i == 0)
-                    const_c = c;
-                else
-                    C[prm.degree - i] = -c / const_c;
-            }
-            C[0] = -1 / const_c;
+            theta = detail::chebyshev_coefficients<V>(emax * prm.lower, emax, prm.degree, C);
         }
 
         /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
@@ -150,29 +243,174 @@ class chebyshev {
             apply(A, rhs, x, tmp);
         }
 
+        /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre_and_residual
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply_pre_and_residual(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                const params&, bool zero_x
+                ) const
+        {
+            apply(A, rhs, x, tmp, zero_x, true);
+        }
+
+        /// Estimate of the spectral radius the polynomial was built for.
+        value_type eigmax() const {
+            return emax;
+        }
+
     private:
-        std::vector<value_type> C;
+        value_type emax, theta;
+        std::vector< std::pair<value_type, value_type> > C;
+        boost::shared_ptr<vector> M;
         mutable boost::shared_ptr<vector> p, q;
 
         template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
         void apply(
-                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &res
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &res,
+                bool zero_x = false, bool residual = false
                 ) const
         {
-            backend::residual(rhs, A, x, res);
-            backend::axpby(C[0], res, 0, *p);
+            typedef std::pair<value_type, value_type> coef;
 
-            BOOST_FOREACH(value_type c, boost::make_iterator_range(C.begin() + 1, C.end()))
-            {
-                backend::spmv(1, A, *p, 0, *q);
-                backend::axpbypcz(c, res, 1, *q, 0, *p);
+            if (zero_x)
+                backend::copy(rhs, res);
+            else
+                backend::residual(rhs, A, x, res);
+
+            vector *d0 = p.get();
+            vector *d1 = q.get();
+
+            if (M)
+                backend::vmul(1 / theta, *M, res, 0, *d0);
+            else
+                backend::axpby(1 / theta, res, 0, *d0);
+
+            backend::axpby(1, *d0, 1, x);
+
+            BOOST_FOREACH(const coef &c, C) {
+                detail::chebyshev_step<Matrix, vector, VectorTMP, VectorX>::apply(
+                        c.first, c.second, A, M.get(), res, *d0, *d1, x);
+                std::swap(d0, d1);
+            }
+
+            // Residual of the updated solution.
+            if (residual) backend::spmv(-1, A, *d0, 1, res);
+        }
+
+        // Inverted diagonal of the matrix.
+        template <class Matrix>
+        static std::vector<value_type> inverted_diagonal(const Matrix &A) {
+            typedef typename backend::row_iterator<Matrix>::type row_iterator;
+            const ptrdiff_t n = rows(A);
+
+            std::vector<value_type> dia(n, 1);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(row_iterator a = backend::row_begin(A, i); a; ++a) {
+                    if (a.col() == i) {
+                        dia[i] = 1 / a.value();
+                        break;
+                    }
+                }
+            }
+
+            return dia;
+        }
+
+        // Estimates the largest eigenvalue of A (or D^-1 A) with a few
+        // steps of Lanczos method. The matrix is assumed to be symmetric.
+        // In the scaled case, the symmetric matrix D^-1/2 A D^-1/2 is used,
+        // which has the same spectrum as D^-1 A.
+        template <class Matrix>
+        static value_type lanczos(const Matrix &A, bool scale, unsigned iters) {
+            const ptrdiff_t n = rows(A);
+
+            std::vector<value_type> v0(n, 0), v1(n), w(n), s, t;
+
+            if (scale) {
+                s = inverted_diagonal(A);
+                for(ptrdiff_t i = 0; i < n; ++i) s[i] = sqrt(std::fabs(s[i]));
+                t.resize(n);
+            }
+
+            std::vector<value_type> alpha, beta;
+
+            // Deterministic pseudo-random starting vector.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                v1[i] = 0.5 + static_cast<value_type>((i * 1103515245UL + 12345UL) % 1024) / 1024;
+
+            backend::axpby(0, v0, 1 / sqrt(backend::inner_product(v1, v1)), v1);
+
+            value_type b = 0;
+            for(unsigned k = 0; k < iters; ++k) {
+                if (scale) {
+                    backend::vmul(1, s, v1, 0, t);
+                    backend::spmv(1, A, t, 0, w);
+                    backend::vmul(1, s, w, 0, w);
+                } else {
+                    backend::spmv(1, A, v1, 0, w);
+                }
+
+                value_type a = backend::inner_product(w, v1);
+                backend::axpbypcz(-a, v1, -b, v0, 1, w);
+
+                alpha.push_back(a);
+
+                b = sqrt(backend::inner_product(w, w));
+                if (b < amgcl::detail::eps<value_type>(1) * std::fabs(a)) break;
+
+                beta.push_back(b);
+
+                v0.swap(v1);
+                backend::axpby(1 / b, w, 0, v1);
+            }
+
+            return tridiagonal_emax(alpha, beta);
+        }
+
+        // The largest eigenvalue of a symmetric tridiagonal matrix with the
+        // given diagonal and off-diagonal. Uses bisection with Sturm sequence.
+        static value_type tridiagonal_emax(
+                const std::vector<value_type> &alpha,
+                const std::vector<value_type> &beta)
+        {
+            const size_t m = alpha.size();
+
+            value_type lo = 0, hi = 0;
+            for(size_t i = 0; i < m; ++i) {
+                value_type r = (i > 0 ? std::fabs(beta[i-1]) : 0) +
+                               (i + 1 < m ? std::fabs(beta[i]) : 0);
+
+                lo = std::min(lo, alpha[i] - r);
+                hi = std::max(hi, alpha[i] + r);
+            }
+
+            for(int k = 0; k < 60 && hi - lo > amgcl::detail::eps<value_type>(1) * std::fabs(hi); ++k) {
+                value_type x = (lo + hi) / 2;
+
+                // Number of eigenvalues smaller than x.
+                size_t count = 0;
+                value_type q = 1;
+                for(size_t i = 0; i < m; ++i) {
+                    value_type b2 = (i > 0) ? beta[i-1] * beta[i-1] : 0;
+                    q = alpha[i] - x - (i > 0 ? b2 / q : 0);
+
+                    if (q == 0) q = amgcl::detail::eps<value_type>(1);
+                    if (q < 0) ++count;
+                }
+
+                if (count == m) hi = x; else lo = x;
             }
 
-            backend::axpby(1, *p, 1, x);
+            return hi;
         }
 
+        // Upper bound for the spectral radius of A (or D^-1 A) by Gershgorin
+        // theorem.
         template <class Matrix>
-        static value_type spectral_radius(const Matrix &A) {
+        static value_type spectral_radius(const Matrix &A, bool scale) {
             typedef typename backend::row_iterator<Matrix>::type row_iterator;
             const size_t n = rows(A);
 
@@ -193,12 +431,16 @@ class chebyshev {
 #endif
                 value_type my_emax = 0;
                 for(size_t i = chunk_start; i < chunk_end; ++i) {
-                    value_type hi = 0;
+                    value_type hi = 0, dia = 1;
+
+                    for(row_iterator a = backend::row_begin(A, i); a; ++a) {
+                        if (scale && static_cast<size_t>(a.col()) == i)
+                            dia = std::fabs( a.value() );
 
-                    for(row_iterator a = backend::row_begin(A, i); a; ++a)
                         hi += std::fabs( a.value() );
+                    }
 
-                    my_emax = std::max(my_emax, hi);
+                    my_emax = std::max(my_emax, hi / dia);
                 }
 
 #pragma omp critical
@@ -209,6 +451,17 @@ class chebyshev {
         }
 };
 
+template <class Backend>
+struct provides_apply_pre_and_residual< chebyshev<Backend> >
+    : boost::true_type
+{};
+
+/// Reports the spectral radius estimate used by the smoother.
+template <class Backend>
+void print_info(std::ostream &os, const chebyshev<Backend> &r) {
+    os << "chebyshev: eigmax = " << r.eigmax();
+}
+
 } // namespace relaxation
 } // namespace amgcl
 
@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 #include <boost/shared_ptr.hpp>
 #include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/interface.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -120,6 +121,31 @@ struct damped_jacobi {
         apply(A, rhs, x, tmp, prm);
     }
 
+    /// Apply pre-relaxation and compute residual of the updated solution.
+    /**
+     * \param A      System matrix.
+     * \param rhs    Right-hand side.
+     * \param x      Solution vector.
+     * \param tmp    Residual of the updated solution on output.
+     * \param prm    Relaxation parameters.
+     * \param zero_x The solution is known to be zero on input.
+     *
+     * \sa amgcl::relaxation::provides_apply_pre_and_residual
+     */
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre_and_residual(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm, bool zero_x
+            ) const
+    {
+        if (zero_x)
+            backend::vmul(prm.damping, *dia, rhs, 0, x);
+        else
+            apply(A, rhs, x, tmp, prm);
+
+        backend::residual(rhs, A, x, tmp);
+    }
+
     private:
         template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
         void apply(
@@ -132,6 +158,11 @@ struct damped_jacobi {
         }
 };
 
+template <class Backend>
+struct provides_apply_pre_and_residual< damped_jacobi<Backend> >
+    : boost::true_type
+{};
+
 } // namespace relaxation
 } // namespace amgcl
 
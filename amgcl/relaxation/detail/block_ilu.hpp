@@ -0,0 +1,168 @@
+#ifndef AMGCL_RELAXATION_DETAIL_BLOCK_ILU_HPP
+#define AMGCL_RELAXATION_DETAIL_BLOCK_ILU_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/detail/block_ilu.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Incomplete LU factorization over independent row blocks.
+ */
+
+
+#include <vector>
+#include <algorithm>
+
+#include <boost/range/numeric.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+
+namespace amgcl {
+namespace relaxation {
+namespace detail {
+
+/// Partial incomplete LU factors for a contiguous block of rows.
+/**
+ * Column numbers are local to the block. The strictly upper part of the
+ * factor is kept separately from the (inverted) diagonal.
+ */
+template <typename value_type>
+struct ilu_block {
+    ptrdiff_t beg, end;
+
+    std::vector<ptrdiff_t>  Lptr, Lcol;
+    std::vector<value_type> Lval;
+
+    std::vector<ptrdiff_t>  Uptr, Ucol;
+    std::vector<value_type> Uval;
+
+    std::vector<value_type> D;
+
+    ilu_block(ptrdiff_t beg = 0, ptrdiff_t end = 0)
+        : beg(beg), end(end), Lptr(1, 0), Uptr(1, 0)
+    {
+        D.reserve(end - beg);
+    }
+
+    ptrdiff_t size() const {
+        return end - beg;
+    }
+};
+
+/// Computes incomplete LU factorization over independent row blocks.
+/**
+ * The matrix is split into \p nblocks contiguous row blocks, and the
+ * couplings between the blocks are ignored by the factorization. The blocks
+ * are factorized in parallel. Within a block, rows are factorized in order by
+ * the row kernel \p Factor, which is constructed for each block as
+ * <tt>Factor(A, block, prm)</tt> and is invoked for each (global) row number
+ * of the block.
+ *
+ * With a single block this is the usual (serial) incomplete factorization.
+ *
+ * \param A       The system matrix.
+ * \param prm     Parameters passed to the row kernel.
+ * \param nblocks Number of row blocks.
+ * \param L       Strictly lower part of the factorization.
+ * \param U       Strictly upper part of the factorization.
+ * \param D       Inverted diagonal of the factorization.
+ */
+template <class Factor, class Matrix, class Params, typename value_type>
+void block_ilu(
+        const Matrix &A, const Params &prm, ptrdiff_t nblocks,
+        backend::crs<value_type, ptrdiff_t, ptrdiff_t> &L,
+        backend::crs<value_type, ptrdiff_t, ptrdiff_t> &U,
+        std::vector<value_type> &D
+        )
+{
+    const ptrdiff_t n = backend::rows(A);
+
+    nblocks = std::max<ptrdiff_t>(1, std::min(nblocks, n));
+
+    std::vector< ilu_block<value_type> > block;
+    block.reserve(nblocks);
+
+    for(ptrdiff_t b = 0; b < nblocks; ++b)
+        block.push_back(ilu_block<value_type>(b * n / nblocks, (b + 1) * n / nblocks));
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for(ptrdiff_t b = 0; b < nblocks; ++b) {
+        Factor factor(A, block[b], prm);
+
+        for(ptrdiff_t i = block[b].beg; i < block[b].end; ++i)
+            factor(i);
+    }
+
+    // Assemble the factors.
+    L.nrows = L.ncols = n;
+    U.nrows = U.ncols = n;
+
+    L.ptr.resize(n + 1);
+    U.ptr.resize(n + 1);
+    D.resize(n);
+
+    L.ptr[0] = 0;
+    U.ptr[0] = 0;
+
+    for(ptrdiff_t b = 0; b < nblocks; ++b) {
+        const ilu_block<value_type> &B = block[b];
+
+        for(ptrdiff_t r = 0; r < B.size(); ++r) {
+            L.ptr[B.beg + r + 1] = B.Lptr[r + 1] - B.Lptr[r];
+            U.ptr[B.beg + r + 1] = B.Uptr[r + 1] - B.Uptr[r];
+        }
+    }
+
+    boost::partial_sum(L.ptr, L.ptr.begin());
+    boost::partial_sum(U.ptr, U.ptr.begin());
+
+    L.col.resize(L.ptr.back());
+    L.val.resize(L.ptr.back());
+    U.col.resize(U.ptr.back());
+    U.val.resize(U.ptr.back());
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for(ptrdiff_t b = 0; b < nblocks; ++b) {
+        const ilu_block<value_type> &B = block[b];
+
+        for(ptrdiff_t j = 0, l = L.ptr[B.beg]; j < B.Lptr.back(); ++j, ++l) {
+            L.col[l] = B.Lcol[j] + B.beg;
+            L.val[l] = B.Lval[j];
+        }
+
+        for(ptrdiff_t j = 0, u = U.ptr[B.beg]; j < B.Uptr.back(); ++j, ++u) {
+            U.col[u] = B.Ucol[j] + B.beg;
+            U.val[u] = B.Uval[j];
+        }
+
+        std::copy(B.D.begin(), B.D.end(), D.begin() + B.beg);
+    }
+}
+
+} // namespace detail
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef AMGCL_RELAXATION_DETAIL_ILU_SOLVE_HPP
+#define AMGCL_RELAXATION_DETAIL_ILU_SOLVE_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/detail/ilu_solve.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Level-scheduled sparse triangular solver for ILU-type smoothers.
+ */
+
+#include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <boost/range/algorithm.hpp>
+#include <boost/range/numeric.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+
+namespace amgcl {
+namespace relaxation {
+namespace detail {
+
+/// Sparse triangular solver with level scheduling.
+/**
+ * The rows of the triangular factor are split into level sets (wavefronts),
+ * so that rows inside a level only depend on rows from the previous levels.
+ * Each level is partitioned between OpenMP threads, and the factor is stored
+ * reordered by thread and level, so that every thread sweeps over contiguous
+ * memory. Threads are synchronized between the levels.
+ *
+ * When the levels are too narrow for the synchronization overhead to pay off
+ * (or when there is a single thread), the solver falls back to the usual
+ * serial substitution.
+ *
+ * \tparam value_type Value type.
+ * \tparam lower      Solve with the strictly lower factor (unit diagonal is
+ *                    implied) when true, and with the strictly upper factor
+ *                    scaled by the inverted diagonal otherwise.
+ */
+template <typename value_type, bool lower>
+class sptr_solve {
+    public:
+        /// Minimum average number of rows per thread in a level.
+        /**
+         * Level scheduling is only used when the average level is wide enough
+         * to amortize the cost of a thread barrier.
+         */
+        static const ptrdiff_t min_rows_per_thread = 64;
+
+        /// Prepares the solver for the given factor.
+        /**
+         * \param A The strictly lower (upper) triangular factor.
+         * \param D The inverted diagonal of the factor (upper factor only).
+         */
+        template <class Matrix>
+        sptr_solve(const Matrix &A, const value_type *D = 0) : nlev(0)
+        {
+            const ptrdiff_t n = backend::rows(A);
+
+#ifdef _OPENMP
+            nthreads = omp_get_max_threads();
+#else
+            nthreads = 1;
+#endif
+
+            // Find level of each row.
+            std::vector<ptrdiff_t> level(n, 0);
+
+            for(ptrdiff_t k = 0; k < n; ++k) {
+                ptrdiff_t i = lower ? k : n - k - 1;
+                ptrdiff_t l = 0;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    l = std::max(l, level[A.col[j]] + 1);
+
+                level[i] = l;
+                nlev = std::max(nlev, l + 1);
+            }
+
+            // Sort rows by level.
+            std::vector<ptrdiff_t> start;
+            std::vector<ptrdiff_t> order(n);
+
+            if (nthreads > 1 && n >= nlev * nthreads * min_rows_per_thread) {
+                start.resize(nlev + 1, 0);
+
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    ++start[level[i] + 1];
+
+                boost::partial_sum(start, start.begin());
+
+                for(ptrdiff_t k = 0; k < n; ++k) {
+                    ptrdiff_t i = lower ? k : n - k - 1;
+                    order[start[level[i]]++] = i;
+                }
+
+                std::rotate(start.begin(), start.end() - 1, start.end());
+                start.front() = 0;
+            } else {
+                // Serial fallback: single level with rows in natural order.
+                nthreads = 1;
+                nlev     = 1;
+
+                start.resize(2);
+                start[0] = 0;
+                start[1] = n;
+
+                for(ptrdiff_t k = 0; k < n; ++k)
+                    order[k] = lower ? k : n - k - 1;
+            }
+
+            ptr.resize(nthreads);
+            col.resize(nthreads);
+            val.resize(nthreads);
+            ord.resize(nthreads);
+            dia.resize(nthreads);
+            task.resize(nthreads);
+
+            // Each thread copies its part of the factor, so that the memory
+            // is allocated close to the thread that is going to use it.
+#pragma omp parallel num_threads(nthreads)
+            {
+#ifdef _OPENMP
+                int nt  = omp_get_num_threads();
+                int tid = omp_get_thread_num();
+#else
+                int nt  = 1;
+                int tid = 0;
+#endif
+
+                for(int t = tid; t < nthreads; t += nt) {
+                    std::vector<ptrdiff_t>  &my_ptr  = ptr[t];
+                    std::vector<ptrdiff_t>  &my_col  = col[t];
+                    std::vector<value_type> &my_val  = val[t];
+                    std::vector<ptrdiff_t>  &my_ord  = ord[t];
+                    std::vector<value_type> &my_dia  = dia[t];
+                    std::vector<range>      &my_task = task[t];
+
+                    my_task.reserve(nlev);
+                    my_ptr.push_back(0);
+
+                    for(ptrdiff_t l = 0; l < nlev; ++l) {
+                        ptrdiff_t size  = start[l + 1] - start[l];
+                        ptrdiff_t chunk = (size + nthreads - 1) / nthreads;
+                        ptrdiff_t beg   = std::min(start[l] + t * chunk, start[l + 1]);
+                        ptrdiff_t end   = std::min(beg + chunk, start[l + 1]);
+
+                        my_task.push_back(range(my_ord.size(), my_ord.size() + end - beg));
+
+                        for(ptrdiff_t r = beg; r < end; ++r) {
+                            ptrdiff_t i = order[r];
+
+                            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                                my_col.push_back(A.col[j]);
+                                my_val.push_back(A.val[j]);
+                            }
+
+                            my_ptr.push_back(my_col.size());
+                            my_ord.push_back(i);
+
+                            if (!lower) my_dia.push_back(D[i]);
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Solves the triangular system in-place.
+        template <class Vector>
+        void solve(Vector &x) const {
+#pragma omp parallel num_threads(nthreads)
+            {
+#ifdef _OPENMP
+                int nt  = omp_get_num_threads();
+                int tid = omp_get_thread_num();
+#else
+                int nt  = 1;
+                int tid = 0;
+#endif
+
+                for(ptrdiff_t l = 0; l < nlev; ++l) {
+                    for(int t = tid; t < nthreads; t += nt) {
+                        const ptrdiff_t  *p = &ptr[t][0];
+                        const ptrdiff_t  *c = col[t].empty() ? 0 : &col[t][0];
+                        const value_type *v = val[t].empty() ? 0 : &val[t][0];
+
+                        for(ptrdiff_t r = task[t][l].first; r < task[t][l].second; ++r) {
+                            ptrdiff_t  i = ord[t][r];
+                            value_type X = 0;
+
+                            for(ptrdiff_t j = p[r], e = p[r + 1]; j < e; ++j)
+                                X += v[j] * x[c[j]];
+
+                            if (lower)
+                                x[i] -= X;
+                            else
+                                x[i] = dia[t][r] * (x[i] - X);
+                        }
+                    }
+
+#pragma omp barrier
+                }
+            }
+        }
+
+        /// Number of level sets used by the solver.
+        ptrdiff_t levels() const {
+            return nlev;
+        }
+
+    private:
+        typedef std::pair<ptrdiff_t, ptrdiff_t> range;
+
+        int       nthreads;
+        ptrdiff_t nlev;
+
+        std::vector< std::vector<ptrdiff_t>  > ptr;
+        std::vector< std::vector<ptrdiff_t>  > col;
+        std::vector< std::vector<value_type> > val;
+        std::vector< std::vector<ptrdiff_t>  > ord;
+        std::vector< std::vector<value_type> > dia;
+        std::vector< std::vector<range>      > task;
+};
+
+} // namespace detail
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef AMGCL_RELAXATION_DETAIL_SPAI_HPP
+#define AMGCL_RELAXATION_DETAIL_SPAI_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/detail/spai.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Least-squares setup for sparse approximate inverse smoothers.
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/detail/qr.hpp>
+
+namespace amgcl {
+namespace relaxation {
+namespace detail {
+
+/// Computes the sparse approximate inverse for the given sparsity pattern.
+/**
+ * Each row \f$m_i\f$ of the approximate inverse minimizes
+ * \f$\|m_i A - e_i\|_2\f$ over the nonzero pattern of the row. The patterns of
+ * \p M (\p ptr and \p col) should be set on input, the values are computed.
+ * Rows are independent and are processed in parallel.
+ */
+template <class Matrix, class Inverse>
+void spai_values(const Matrix &A, Inverse &M) {
+    typedef typename backend::value_type<Matrix>::type   value_type;
+    typedef typename backend::row_iterator<Matrix>::type row_iterator;
+
+    const ptrdiff_t n = backend::rows(A);
+    const ptrdiff_t m = backend::cols(A);
+
+    M.val.resize(M.ptr[n]);
+
+#pragma omp parallel
+    {
+        // Work buffers are private to each thread and only grow, so that
+        // no heap allocations happen once they reach the maximum row size.
+        std::vector<ptrdiff_t> marker(m, -1);
+        std::vector<ptrdiff_t> J;
+        std::vector<value_type> B, ek;
+        amgcl::detail::QR<value_type, amgcl::detail::col_major> qr;
+
+        // The local least-squares problems vary wildly in size, so rows
+        // are distributed between threads dynamically.
+#pragma omp for schedule(dynamic, 64)
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t row_beg = M.ptr[i];
+            ptrdiff_t row_end = M.ptr[i + 1];
+            size_t    row_len = row_end - row_beg;
+
+            J.clear();
+            for(ptrdiff_t j = row_beg; j < row_end; ++j) {
+                ptrdiff_t c = M.col[j];
+
+                for(row_iterator a = backend::row_begin(A, c); a; ++a) {
+                    ptrdiff_t cc = a.col();
+                    if (marker[cc] < 0) {
+                        marker[cc] = 1;
+                        J.push_back(cc);
+                    }
+                }
+            }
+            std::sort(J.begin(), J.end());
+            B.assign(row_len * J.size(), 0);
+            ek.assign(J.size(), 0);
+            for(size_t j = 0; j < J.size(); ++j) {
+                marker[J[j]] = j;
+                if (J[j] == i) ek[j] = 1;
+            }
+
+            // B is stored column-wise, so that each row of A fills a
+            // contiguous column of B.
+            for(ptrdiff_t j = row_beg; j < row_end; ++j) {
+                value_type *b = &B[(j - row_beg) * J.size()];
+
+                for(row_iterator a = backend::row_begin(A, M.col[j]); a; ++a)
+                    b[marker[a.col()]] = a.value();
+            }
+
+            qr.compute(J.size(), row_len, B.data(), /*need Q: */false);
+            qr.solve(ek.data(), &M.val[row_beg]);
+
+            for(size_t j = 0; j < J.size(); ++j)
+                marker[J[j]] = -1;
+        }
+    }
+}
+
+} // namespace detail
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef AMGCL_RELAXATION_HYBRID_GAUSS_SEIDEL_HPP
+#define AMGCL_RELAXATION_HYBRID_GAUSS_SEIDEL_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/hybrid_gauss_seidel.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Hybrid Gauss-Seidel relaxation scheme.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// Hybrid Gauss-Seidel relaxation.
+/**
+ * The rows of the matrix are split into contiguous blocks (one per OpenMP
+ * thread by default). Gauss-Seidel iteration is used inside each block
+ * (forward sweep for pre-relaxation, backward sweep for post-relaxation),
+ * while the blocks are coupled in the Jacobi fashion: values from the other
+ * blocks are taken from the previous iterate. For a given number of blocks,
+ * the result does not depend on the number of threads.
+ *
+ * With \p l1 set, the diagonal of each row is augmented with the sum of
+ * absolute values of the couplings to the other blocks, which makes the
+ * smoother convergent for any SPD matrix \cite Baker2011.
+ *
+ * \note This relaxation is only applicable to backends that support matrix
+ * row iteration (e.g. amgcl::backend::builtin or amgcl::backend::eigen).
+ *
+ * \param Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ */
+template <class Backend>
+struct hybrid_gauss_seidel {
+    typedef typename Backend::value_type value_type;
+
+    /// Relaxation parameters.
+    struct params {
+        /// Use l1 diagonal scaling.
+        bool l1;
+
+        /// Number of row blocks.
+        /**
+         * When zero, the number of OpenMP threads is used.
+         */
+        int blocks;
+
+        params(bool l1 = false, int blocks = 0) : l1(l1), blocks(blocks) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, l1),
+              AMGCL_PARAMS_IMPORT_VALUE(p, blocks)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, l1);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, blocks);
+        }
+    };
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+    template <class Matrix>
+    hybrid_gauss_seidel( const Matrix &A, const params &prm, const typename Backend::params&)
+        : nblocks(prm.blocks), dia(backend::rows(A)), inv(backend::rows(A))
+    {
+        const ptrdiff_t n = backend::rows(A);
+
+        if (nblocks <= 0) {
+#ifdef _OPENMP
+            nblocks = omp_get_max_threads();
+#else
+            nblocks = 1;
+#endif
+        }
+
+        nblocks = std::max<ptrdiff_t>(1, std::min<ptrdiff_t>(nblocks, n));
+
+#pragma omp parallel for
+        for(ptrdiff_t b = 0; b < nblocks; ++b) {
+            ptrdiff_t beg = block_start(b, n);
+            ptrdiff_t end = block_start(b + 1, n);
+
+            for(ptrdiff_t i = beg; i < end; ++i) {
+                value_type d = 1, s = 0;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+
+                    if (c == i)
+                        d = A.val[j];
+                    else if (c < beg || c >= end)
+                        s += fabs(A.val[j]);
+                }
+
+                dia[i] = d;
+                inv[i] = 1 / (prm.l1 ? d + s : d);
+            }
+        }
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp, const params&
+            ) const
+    {
+        iterate(A, rhs, x, tmp, true);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp, const params&
+            ) const
+    {
+        iterate(A, rhs, x, tmp, false);
+    }
+
+    private:
+        ptrdiff_t nblocks;
+        std::vector<value_type> dia; // Diagonal of the matrix.
+        std::vector<value_type> inv; // Inverted (l1-)diagonal.
+
+        ptrdiff_t block_start(ptrdiff_t b, ptrdiff_t n) const {
+            return b * n / nblocks;
+        }
+
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void iterate(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                bool forward
+                ) const
+        {
+            typedef typename backend::row_iterator<Matrix>::type row_iterator;
+
+            const ptrdiff_t n = backend::rows(A);
+
+            // Previous iterate for the couplings between the blocks.
+            backend::copy(x, tmp);
+
+#pragma omp parallel for
+            for(ptrdiff_t b = 0; b < nblocks; ++b) {
+                ptrdiff_t beg = block_start(b, n);
+                ptrdiff_t end = block_start(b + 1, n);
+
+                for(ptrdiff_t k = beg; k < end; ++k) {
+                    ptrdiff_t  i    = forward ? k : beg + end - k - 1;
+                    value_type temp = rhs[i];
+
+                    for (row_iterator a = backend::row_begin(A, i); a; ++a) {
+                        ptrdiff_t c = a.col();
+
+                        if (c == i) continue;
+
+                        if (c < beg || c >= end)
+                            temp -= a.value() * tmp[c];
+                        else
+                            temp -= a.value() * x[c];
+                    }
+
+                    x[i] += inv[i] * (temp - dia[i] * x[i]);
+                }
+            }
+        }
+};
+
+} // namespace relaxation
+
+namespace backend {
+
+template <class Backend>
+struct relaxation_is_supported<
+    Backend,
+    relaxation::hybrid_gauss_seidel,
+    typename boost::disable_if<
+            typename Backend::provides_row_iterator
+        >::type
+    > : boost::false_type
+{};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
@@ -8,7 +8,9 @@
  */
 
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/detail/ilu_solve.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -16,9 +18,11 @@ namespace relaxation {
 
 /// ILU(0) smoother.
 /**
- * \note ILU(0) is a serial algorithm and is only applicable to backends that
- * support matrix row iteration (e.g. amgcl::backend::builtin or
- * amgcl::backend::eigen).
+ * \note ILU(0) factorization is a serial algorithm and is only applicable to
+ * backends that support matrix row iteration (e.g. amgcl::backend::builtin).
+ * The triangular solves are level-scheduled: rows of each factor are split
+ * into independent wavefronts that are processed in parallel (see
+ * amgcl::relaxation::detail::sptr_solve).
  *
  * \param Backend Backend for temporary structures allocation.
  * \ingroup relaxation
@@ -47,13 +51,13 @@ struct ilu0 {
     /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
     template <class Matrix>
     ilu0( const Matrix &A, const params &, const typename Backend::params&)
-        : luval( A.val ),
-          dia  ( backend::rows(A) )
     {
         const size_t n = backend::rows(A);
         const value_type eps = amgcl::detail::eps<value_type>(1);
 
-        std::vector<ptrdiff_t> work(n, -1);
+        std::vector<value_type> luval(A.val);
+        std::vector<ptrdiff_t>  dia(n);
+        std::vector<ptrdiff_t>  work(n, -1);
 
         for(size_t i = 0; i < n; ++i) {
             ptrdiff_t row_beg = A.ptr[i];
@@ -96,6 +100,48 @@ struct ilu0 {
             for(ptrdiff_t j = row_beg; j < row_end; ++j)
                 work[A.col[j]] = -1;
         }
+
+        // Split the factorization into strictly lower and upper parts and
+        // the (inverted) diagonal.
+        build_matrix L, U;
+        std::vector<value_type> D(n);
+
+        L.nrows = L.ncols = n;
+        U.nrows = U.ncols = n;
+
+        L.ptr.resize(n + 1, 0);
+        U.ptr.resize(n + 1, 0);
+
+        for(size_t i = 0; i < n; ++i) {
+            L.ptr[i + 1] = L.ptr[i] + dia[i] - A.ptr[i];
+            U.ptr[i + 1] = U.ptr[i] + A.ptr[i + 1] - dia[i] - 1;
+        }
+
+        L.col.resize(L.ptr.back());
+        L.val.resize(L.ptr.back());
+        U.col.resize(U.ptr.back());
+        U.val.resize(U.ptr.back());
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i) {
+            ptrdiff_t l = L.ptr[i];
+            ptrdiff_t u = U.ptr[i];
+
+            for(ptrdiff_t j = A.ptr[i]; j < dia[i]; ++j, ++l) {
+                L.col[l] = A.col[j];
+                L.val[l] = luval[j];
+            }
+
+            D[i] = luval[dia[i]];
+
+            for(ptrdiff_t j = dia[i] + 1; j < A.ptr[i + 1]; ++j, ++u) {
+                U.col[u] = A.col[j];
+                U.val[u] = luval[j];
+            }
+        }
+
+        lower = boost::make_shared<lower_solver>(L);
+        upper = boost::make_shared<upper_solver>(U, D.data());
     }
 
     /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
@@ -119,8 +165,12 @@ struct ilu0 {
     }
 
     private:
-        std::vector<value_type> luval;
-        std::vector<ptrdiff_t>  dia;
+        typedef backend::crs<value_type, ptrdiff_t, ptrdiff_t> build_matrix;
+        typedef detail::sptr_solve<value_type, true>  lower_solver;
+        typedef detail::sptr_solve<value_type, false> upper_solver;
+
+        boost::shared_ptr<lower_solver> lower;
+        boost::shared_ptr<upper_solver> upper;
 
         template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
         void apply(
@@ -128,30 +178,12 @@ struct ilu0 {
                 const params &prm
                 ) const
         {
-            const size_t n = backend::rows(A);
-
-#pragma omp parallel for
-            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i) {
-                value_type buf = rhs[i];
-                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j)
-                    buf -= A.val[j] * x[A.col[j]];
-                tmp[i] = buf;
-            }
-
-            for(size_t i = 0; i < n; i++) {
-                for(ptrdiff_t j = A.ptr[i], e = dia[i]; j < e; ++j)
-                    tmp[i] -= luval[j] * tmp[A.col[j]];
-            }
+            backend::residual(rhs, A, x, tmp);
 
-            for(size_t i = n; i-- > 0;) {
-                for(ptrdiff_t j = dia[i] + 1, e = A.ptr[i + 1]; j < e; ++j)
-                    tmp[i] -= luval[j] * tmp[A.col[j]];
-                tmp[i] *= luval[dia[i]];
-            }
+            lower->solve(tmp);
+            upper->solve(tmp);
 
-#pragma omp parallel for
-            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
-                x[i] += prm.damping * tmp[i];
+            backend::axpby(prm.damping, tmp, 1, x);
         }
 
 };
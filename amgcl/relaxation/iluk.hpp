@@ -0,0 +1,285 @@
+#ifndef AMGCL_RELAXATION_ILUK_HPP
+#define AMGCL_RELAXATION_ILUK_HPP
+
+/**
+ * \file   amgcl/relaxation/iluk.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Incomplete LU with fill-in level relaxation scheme.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/detail/block_ilu.hpp>
+#include <amgcl/relaxation/detail/ilu_solve.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// ILU(k) smoother.
+/**
+ * Incomplete LU factorization where fill-in entries are kept up to the given
+ * level of fill. Level zero corresponds to the nonzero entries of the system
+ * matrix, so that ILU(0) is a special case of ILU(k).
+ *
+ * The factorization is computed in parallel over independent row blocks (see
+ * amgcl::relaxation::detail::block_ilu). The couplings between the blocks are
+ * ignored by the factors, so the smoother becomes somewhat weaker as the
+ * number of blocks grows.
+ *
+ * \note The factorization is only applicable to backends that support matrix
+ * row iteration (e.g. amgcl::backend::builtin).
+ *
+ * \param Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ */
+template <class Backend>
+struct iluk {
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::vector     vector;
+
+    /// Relaxation parameters.
+    struct params {
+        /// Level of fill-in.
+        int k;
+
+        /// Damping factor.
+        float damping;
+
+        /// Number of independent row blocks for the factorization.
+        /**
+         * When zero, the number of OpenMP threads is used.
+         */
+        int blocks;
+
+        params(int k = 1, float damping = 0.8, int blocks = 0)
+            : k(k), damping(damping), blocks(blocks) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, k),
+              AMGCL_PARAMS_IMPORT_VALUE(p, damping),
+              AMGCL_PARAMS_IMPORT_VALUE(p, blocks)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, k);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, damping);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, blocks);
+        }
+    };
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+    template <class Matrix>
+    iluk( const Matrix &A, const params &prm, const typename Backend::params&)
+    {
+        int nblocks = prm.blocks;
+
+        if (nblocks <= 0) {
+#ifdef _OPENMP
+            nblocks = omp_get_max_threads();
+#else
+            nblocks = 1;
+#endif
+        }
+
+        build_matrix L, U;
+        std::vector<value_type> D;
+
+        detail::block_ilu<factor>(A, prm, nblocks, L, U, D);
+
+        m_nonzeros = backend::nonzeros(L) + backend::nonzeros(U) + D.size();
+        m_fill     = 1.0 * m_nonzeros / backend::nonzeros(A);
+
+        lower = boost::make_shared<lower_solver>(L);
+        upper = boost::make_shared<upper_solver>(U, D.data());
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm
+            ) const
+    {
+        apply(A, rhs, x, tmp, prm);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm
+            ) const
+    {
+        apply(A, rhs, x, tmp, prm);
+    }
+
+    /// Number of nonzeros in the factorization (L + U + D).
+    size_t nonzeros() const {
+        return m_nonzeros;
+    }
+
+    /// Ratio of nonzeros in the factorization and in the system matrix.
+    double fill_ratio() const {
+        return m_fill;
+    }
+
+    private:
+        typedef backend::crs<value_type, ptrdiff_t, ptrdiff_t> build_matrix;
+        typedef detail::sptr_solve<value_type, true>  lower_solver;
+        typedef detail::sptr_solve<value_type, false> upper_solver;
+
+        boost::shared_ptr<lower_solver> lower;
+        boost::shared_ptr<upper_solver> upper;
+
+        size_t m_nonzeros;
+        double m_fill;
+
+        // Row kernel of the factorization.
+        struct factor {
+            typedef detail::ilu_block<value_type> block_type;
+
+            const typename backend::builtin<value_type>::matrix &A;
+            block_type &B;
+            int k;
+
+            std::vector<value_type> w;    // Values of the current row.
+            std::vector<int>        lev;  // Fill levels of the current row.
+            std::vector<ptrdiff_t>  nz;   // Nonzero pattern of the current row.
+            std::vector<ptrdiff_t>  heap; // Lower columns yet to eliminate.
+            std::vector<int>        ulev; // Fill levels of the U factor.
+
+            template <class Matrix>
+            factor(const Matrix &A, block_type &B, const params &prm)
+                : A(A), B(B), k(prm.k),
+                  w(B.size(), 0), lev(B.size(), -1)
+            {}
+
+            void add(ptrdiff_t c, value_type v, int l, ptrdiff_t i) {
+                w[c]   = v;
+                lev[c] = l;
+                nz.push_back(c);
+
+                if (c < i) {
+                    heap.push_back(c);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<ptrdiff_t>());
+                }
+            }
+
+            void operator()(ptrdiff_t row) {
+                const ptrdiff_t  i   = row - B.beg;
+                const value_type eps = amgcl::detail::eps<value_type>(1);
+
+                for(ptrdiff_t j = A.ptr[row], e = A.ptr[row+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j] - B.beg;
+                    if (c >= 0 && c < B.size()) add(c, A.val[j], 0, i);
+                }
+
+                precondition(lev[i] == 0, "No diagonal value in system matrix");
+
+                // Eliminate lower entries in the increasing column order.
+                while(!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), std::greater<ptrdiff_t>());
+                    ptrdiff_t c = heap.back();
+                    heap.pop_back();
+
+                    value_type tl = w[c] * B.D[c];
+                    w[c] = tl;
+
+                    for(ptrdiff_t j = B.Uptr[c], e = B.Uptr[c+1]; j < e; ++j) {
+                        ptrdiff_t u = B.Ucol[j];
+                        int       l = lev[c] + ulev[j] + 1;
+
+                        if (lev[u] < 0) {
+                            if (l > k) continue;
+                            add(u, 0, l, i);
+                        } else {
+                            lev[u] = std::min(lev[u], l);
+                        }
+
+                        w[u] -= tl * B.Uval[j];
+                    }
+                }
+
+                // Store the row.
+                std::sort(nz.begin(), nz.end());
+
+                for(std::vector<ptrdiff_t>::const_iterator c = nz.begin(); c != nz.end(); ++c) {
+                    if (*c < i) {
+                        B.Lcol.push_back(*c);
+                        B.Lval.push_back(w[*c]);
+                    } else if (*c == i) {
+                        precondition(fabs(w[i]) > eps, "Zero pivot in ILU");
+                        B.D.push_back(1 / w[i]);
+                    } else {
+                        B.Ucol.push_back(*c);
+                        B.Uval.push_back(w[*c]);
+                        ulev.push_back(lev[*c]);
+                    }
+
+                    w[*c]   = 0;
+                    lev[*c] = -1;
+                }
+
+                B.Lptr.push_back(B.Lcol.size());
+                B.Uptr.push_back(B.Ucol.size());
+
+                nz.clear();
+            }
+        };
+
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                const params &prm
+                ) const
+        {
+            backend::residual(rhs, A, x, tmp);
+
+            lower->solve(tmp);
+            upper->solve(tmp);
+
+            backend::axpby(prm.damping, tmp, 1, x);
+        }
+};
+
+/// Reports the size of the ILU(k) factorization.
+template <class Backend>
+void print_info(std::ostream &os, const iluk<Backend> &r) {
+    os << "iluk: nnz(LU) = " << r.nonzeros()
+       << " (" << std::fixed << std::setprecision(2) << r.fill_ratio() << " x nnz(A))";
+}
+
+} // namespace relaxation
+
+namespace backend {
+
+template <class Backend>
+struct relaxation_is_supported<
+    Backend,
+    relaxation::iluk,
+    typename boost::disable_if<
+            typename boost::is_same<
+                Backend,
+                builtin<typename Backend::value_type>
+            >::type
+        >::type
+    > : boost::false_type
+{};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
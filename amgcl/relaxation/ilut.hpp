@@ -0,0 +1,337 @@
+#ifndef AMGCL_RELAXATION_ILUT_HPP
+#define AMGCL_RELAXATION_ILUT_HPP
+
+/**
+ * \file   amgcl/relaxation/ilut.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Incomplete LU with thresholding relaxation scheme.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/detail/block_ilu.hpp>
+#include <amgcl/relaxation/detail/ilu_solve.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// ILUT smoother.
+/**
+ * Incomplete LU factorization with dual dropping strategy \cite Saad2003.
+ * Entries that are smaller than \p tau times the norm of the current row of
+ * the system matrix are dropped from the factors. Additionally, only \p fill
+ * largest fill-in entries are kept in each row of the L and U factors (on top
+ * of the number of nonzeros in the corresponding part of the original row).
+ *
+ * The factorization is computed in parallel over independent row blocks (see
+ * amgcl::relaxation::detail::block_ilu). The couplings between the blocks are
+ * ignored by the factors, so the smoother becomes somewhat weaker as the
+ * number of blocks grows.
+ *
+ * \note The factorization is only applicable to backends that support matrix
+ * row iteration (e.g. amgcl::backend::builtin).
+ *
+ * \param Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ */
+template <class Backend>
+struct ilut {
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::vector     vector;
+
+    /// Relaxation parameters.
+    struct params {
+        /// Maximum fill-in per row of each of the factors.
+        int fill;
+
+        /// Relative drop tolerance.
+        float tau;
+
+        /// Damping factor.
+        float damping;
+
+        /// Number of independent row blocks for the factorization.
+        /**
+         * When zero, the number of OpenMP threads is used.
+         */
+        int blocks;
+
+        params(int fill = 2, float tau = 1e-2f, float damping = 0.8, int blocks = 0)
+            : fill(fill), tau(tau), damping(damping), blocks(blocks) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, fill),
+              AMGCL_PARAMS_IMPORT_VALUE(p, tau),
+              AMGCL_PARAMS_IMPORT_VALUE(p, damping),
+              AMGCL_PARAMS_IMPORT_VALUE(p, blocks)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, fill);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, tau);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, damping);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, blocks);
+        }
+    };
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+    template <class Matrix>
+    ilut( const Matrix &A, const params &prm, const typename Backend::params&)
+    {
+        int nblocks = prm.blocks;
+
+        if (nblocks <= 0) {
+#ifdef _OPENMP
+            nblocks = omp_get_max_threads();
+#else
+            nblocks = 1;
+#endif
+        }
+
+        build_matrix L, U;
+        std::vector<value_type> D;
+
+        detail::block_ilu<factor>(A, prm, nblocks, L, U, D);
+
+        m_nonzeros = backend::nonzeros(L) + backend::nonzeros(U) + D.size();
+        m_fill     = 1.0 * m_nonzeros / backend::nonzeros(A);
+
+        lower = boost::make_shared<lower_solver>(L);
+        upper = boost::make_shared<upper_solver>(U, D.data());
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm
+            ) const
+    {
+        apply(A, rhs, x, tmp, prm);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm
+            ) const
+    {
+        apply(A, rhs, x, tmp, prm);
+    }
+
+    /// Number of nonzeros in the factorization (L + U + D).
+    size_t nonzeros() const {
+        return m_nonzeros;
+    }
+
+    /// Ratio of nonzeros in the factorization and in the system matrix.
+    double fill_ratio() const {
+        return m_fill;
+    }
+
+    private:
+        typedef backend::crs<value_type, ptrdiff_t, ptrdiff_t> build_matrix;
+        typedef detail::sptr_solve<value_type, true>  lower_solver;
+        typedef detail::sptr_solve<value_type, false> upper_solver;
+
+        boost::shared_ptr<lower_solver> lower;
+        boost::shared_ptr<upper_solver> upper;
+
+        size_t m_nonzeros;
+        double m_fill;
+
+        // Orders row entries by decreasing magnitude.
+        struct by_abs_value {
+            const std::vector<value_type> &w;
+
+            by_abs_value(const std::vector<value_type> &w) : w(w) {}
+
+            bool operator()(ptrdiff_t a, ptrdiff_t b) const {
+                return fabs(w[a]) > fabs(w[b]);
+            }
+        };
+
+        // Row kernel of the factorization.
+        struct factor {
+            typedef detail::ilu_block<value_type> block_type;
+
+            const typename backend::builtin<value_type>::matrix &A;
+            block_type &B;
+            int   fill;
+            float tau;
+
+            std::vector<value_type> w;    // Values of the current row.
+            std::vector<bool>       used; // Nonzero pattern of the current row.
+            std::vector<ptrdiff_t>  nz;   // Nonzero pattern of the current row.
+            std::vector<ptrdiff_t>  heap; // Lower columns yet to eliminate.
+            std::vector<ptrdiff_t>  lo, up;
+
+            template <class Matrix>
+            factor(const Matrix &A, block_type &B, const params &prm)
+                : A(A), B(B), fill(prm.fill), tau(prm.tau),
+                  w(B.size(), 0), used(B.size(), false)
+            {}
+
+            void add(ptrdiff_t c, value_type v, ptrdiff_t i) {
+                w[c]    = v;
+                used[c] = true;
+                nz.push_back(c);
+
+                if (c < i) {
+                    heap.push_back(c);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<ptrdiff_t>());
+                }
+            }
+
+            // Keeps at most n largest entries, sorted by column number.
+            void keep_largest(std::vector<ptrdiff_t> &v, size_t n) {
+                if (v.size() > n) {
+                    std::nth_element(v.begin(), v.begin() + n, v.end(), by_abs_value(w));
+                    v.resize(n);
+                }
+
+                std::sort(v.begin(), v.end());
+            }
+
+            void operator()(ptrdiff_t row) {
+                const ptrdiff_t  i   = row - B.beg;
+                const value_type eps = amgcl::detail::eps<value_type>(1);
+
+                value_type norm = 0;
+                size_t     nlo  = 0;
+                size_t     nup  = 0;
+
+                for(ptrdiff_t j = A.ptr[row], e = A.ptr[row+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j] - B.beg;
+                    if (c < 0 || c >= B.size()) continue;
+
+                    add(c, A.val[j], i);
+
+                    norm += A.val[j] * A.val[j];
+
+                    if (c < i) ++nlo;
+                    if (c > i) ++nup;
+                }
+
+                precondition(used[i], "No diagonal value in system matrix");
+
+                const value_type tol = tau * sqrt(norm);
+
+                // Eliminate lower entries in the increasing column order.
+                while(!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), std::greater<ptrdiff_t>());
+                    ptrdiff_t c = heap.back();
+                    heap.pop_back();
+
+                    // Entries of L are kept unscaled by the pivot until the
+                    // row is stored, so that the drop rule does not depend
+                    // on the matrix scaling.
+                    if (fabs(w[c]) < tol) {
+                        w[c] = 0;
+                        continue;
+                    }
+
+                    value_type tl = w[c] * B.D[c];
+
+                    for(ptrdiff_t j = B.Uptr[c], e = B.Uptr[c+1]; j < e; ++j) {
+                        ptrdiff_t u = B.Ucol[j];
+                        if (!used[u]) add(u, 0, i);
+                        w[u] -= tl * B.Uval[j];
+                    }
+                }
+
+                // Drop small entries and store the row.
+                for(std::vector<ptrdiff_t>::const_iterator c = nz.begin(); c != nz.end(); ++c) {
+                    if (*c == i || w[*c] == 0 || fabs(w[*c]) < tol) continue;
+
+                    if (*c < i) lo.push_back(*c);
+                    if (*c > i) up.push_back(*c);
+                }
+
+                keep_largest(lo, nlo + fill);
+                keep_largest(up, nup + fill);
+
+                for(std::vector<ptrdiff_t>::const_iterator c = lo.begin(); c != lo.end(); ++c) {
+                    B.Lcol.push_back(*c);
+                    B.Lval.push_back(w[*c] * B.D[*c]);
+                }
+
+                precondition(fabs(w[i]) > eps, "Zero pivot in ILU");
+                B.D.push_back(1 / w[i]);
+
+                for(std::vector<ptrdiff_t>::const_iterator c = up.begin(); c != up.end(); ++c) {
+                    B.Ucol.push_back(*c);
+                    B.Uval.push_back(w[*c]);
+                }
+
+                B.Lptr.push_back(B.Lcol.size());
+                B.Uptr.push_back(B.Ucol.size());
+
+                for(std::vector<ptrdiff_t>::const_iterator c = nz.begin(); c != nz.end(); ++c) {
+                    w[*c]    = 0;
+                    used[*c] = false;
+                }
+
+                nz.clear();
+                lo.clear();
+                up.clear();
+            }
+        };
+
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                const params &prm
+                ) const
+        {
+            backend::residual(rhs, A, x, tmp);
+
+            lower->solve(tmp);
+            upper->solve(tmp);
+
+            backend::axpby(prm.damping, tmp, 1, x);
+        }
+};
+
+/// Reports the size of the ILUT factorization.
+template <class Backend>
+void print_info(std::ostream &os, const ilut<Backend> &r) {
+    os << "ilut: nnz(LU) = " << r.nonzeros()
+       << " (" << std::fixed << std::setprecision(2) << r.fill_ratio() << " x nnz(A))";
+}
+
+} // namespace relaxation
+
+namespace backend {
+
+template <class Backend>
+struct relaxation_is_supported<
+    Backend,
+    relaxation::ilut,
+    typename boost::disable_if<
+            typename boost::is_same<
+                Backend,
+                builtin<typename Backend::value_type>
+            >::type
+        >::type
+    > : boost::false_type
+{};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef AMGCL_RELAXATION_INTERFACE_HPP
+#define AMGCL_RELAXATION_INTERFACE_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/interface.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Optional parts of the relaxation interface.
+ */
+
+#include <boost/type_traits.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// Does the relaxation provide fused pre-relaxation and residual?
+/**
+ * A relaxation that specializes this to boost::true_type has to provide the
+ * following method in addition to apply_pre() and apply_post():
+ * \code
+ * template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+ * void apply_pre_and_residual(
+ *         const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+ *         const params &prm, bool zero_x) const;
+ * \endcode
+ * The method does a single pre-relaxation step and leaves the residual of
+ * the updated solution \f$rhs - Ax\f$ in \p tmp. When \p zero_x is set, the
+ * solution is known to be zero on input, so the residual of the initial
+ * approximation equals \p rhs and does not need to be computed.
+ *
+ * amgcl::amg::cycle() uses the method for the last pre-relaxation step,
+ * which saves a matrix-vector product per level whenever the initial
+ * approximation is zero (that is always the case on coarser levels).
+ */
+template <class Relax>
+struct provides_apply_pre_and_residual : boost::false_type {};
+
+/// Creates the relaxation for a level of the AMG hierarchy.
+/**
+ * amgcl::amg creates smoothers through this factory, passing the level
+ * number (zero being the finest level). The default implementation ignores
+ * the level and calls the usual relaxation constructor. A relaxation that
+ * depends on its position in the hierarchy may specialize the factory.
+ */
+template <class Relax>
+struct level_factory {
+    template <class Matrix, class Params, class BackendParams>
+    static Relax* create(const Matrix &A, const Params &prm,
+            const BackendParams &backend_prm, unsigned /*level*/)
+    {
+        return new Relax(A, prm, backend_prm);
+    }
+};
+
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
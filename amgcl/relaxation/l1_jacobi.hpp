@@ -0,0 +1,222 @@
+#ifndef AMGCL_RELAXATION_L1_JACOBI_HPP
+#define AMGCL_RELAXATION_L1_JACOBI_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/l1_jacobi.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  l1-Jacobi relaxation scheme with optional Chebyshev acceleration.
+ */
+
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <boost/shared_ptr.hpp>
+#include <boost/foreach.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/interface.hpp>
+#include <amgcl/relaxation/chebyshev.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// l1-Jacobi smoother.
+/**
+ * Jacobi iteration where the diagonal is augmented with the l1 norm of the
+ * off-diagonal part of each row:
+ * \f[d_i = a_{ii} + \sum_{j \neq i} |a_{ij}|.\f]
+ * The smoother needs no damping parameter, and converges for any SPD
+ * matrix \cite Baker2011.
+ *
+ * When \p degree is greater than one, the l1-Jacobi iteration is accelerated
+ * with Chebyshev polynomial of the given degree. The spectrum of
+ * \f$D_{l1}^{-1}A\f$ lies in (0, 1] for SPD matrices, so no spectral radius
+ * estimate is required.
+ *
+ * \param Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ */
+template <class Backend>
+struct l1_jacobi {
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::vector     vector;
+
+    /// Relaxation parameters.
+    struct params {
+        /// Degree of Chebyshev acceleration (one means plain l1-Jacobi).
+        unsigned degree;
+
+        /// Lowest-to-highest eigen value ratio for Chebyshev acceleration.
+        float lower;
+
+        params(unsigned degree = 1, float lower = 1.0f / 30)
+            : degree(degree), lower(lower) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, degree),
+              AMGCL_PARAMS_IMPORT_VALUE(p, lower)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, degree);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, lower);
+        }
+    };
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+    template <class Matrix>
+    l1_jacobi( const Matrix &A, const params &prm, const typename Backend::params &backend_prm)
+        : theta(1)
+    {
+        typedef typename backend::row_iterator<Matrix>::type row_iterator;
+
+        const size_t n = rows(A);
+
+        std::vector<value_type> m(n);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i) {
+            value_type d = 0;
+
+            for(row_iterator a = backend::row_begin(A, i); a; ++a) {
+                if (a.col() == i)
+                    d += a.value();
+                else
+                    d += std::fabs(a.value());
+            }
+
+            m[i] = 1 / d;
+        }
+
+        M = Backend::copy_vector(m, backend_prm);
+
+        if (prm.degree > 1) {
+            theta = detail::chebyshev_coefficients<value_type>(
+                    prm.lower, 1, prm.degree, C);
+
+            p = Backend::create_vector(n, backend_prm);
+            q = Backend::create_vector(n, backend_prm);
+        }
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&
+            ) const
+    {
+        apply(A, rhs, x, tmp, false, false);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&
+            ) const
+    {
+        apply(A, rhs, x, tmp, false, false);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre_and_residual
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre_and_residual(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&, bool zero_x
+            ) const
+    {
+        apply(A, rhs, x, tmp, zero_x, true);
+    }
+
+    /// Degree of the smoother polynomial.
+    unsigned degree() const {
+        return C.size() + 1;
+    }
+
+    private:
+        value_type theta;
+        std::vector< std::pair<value_type, value_type> > C;
+        boost::shared_ptr<vector> M;
+        mutable boost::shared_ptr<vector> p, q;
+
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &res,
+                bool zero_x, bool residual
+                ) const
+        {
+            typedef std::pair<value_type, value_type> coef;
+
+            if (C.empty()) {
+                if (zero_x) {
+                    backend::vmul(1, *M, rhs, 0, x);
+                } else {
+                    backend::residual(rhs, A, x, res);
+                    backend::vmul(1, *M, res, 1, x);
+                }
+
+                if (residual) backend::residual(rhs, A, x, res);
+                return;
+            }
+
+            if (zero_x)
+                backend::copy(rhs, res);
+            else
+                backend::residual(rhs, A, x, res);
+
+            vector *d0 = p.get();
+            vector *d1 = q.get();
+
+            backend::vmul(1 / theta, *M, res, 0, *d0);
+            backend::axpby(1, *d0, 1, x);
+
+            BOOST_FOREACH(const coef &c, C) {
+                detail::chebyshev_step<Matrix, vector, VectorTMP, VectorX>::apply(
+                        c.first, c.second, A, M.get(), res, *d0, *d1, x);
+                std::swap(d0, d1);
+            }
+
+            if (residual) backend::spmv(-1, A, *d0, 1, res);
+        }
+};
+
+template <class Backend>
+struct provides_apply_pre_and_residual< l1_jacobi<Backend> >
+    : boost::true_type
+{};
+
+/// Reports the degree of the smoother polynomial.
+template <class Backend>
+void print_info(std::ostream &os, const l1_jacobi<Backend> &r) {
+    os << "l1_jacobi: degree = " << r.degree();
+}
+
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
@@ -31,7 +31,11 @@ THE SOFTWARE.
  * \brief  Multicolor Gauss-Seidel relaxation scheme.
  */
 
-#include <boost/graph/sequential_vertex_coloring.hpp>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include <boost/range/numeric.hpp>
 
 #include <amgcl/backend/interface.hpp>
 #include <amgcl/util.hpp>
@@ -41,78 +45,141 @@ namespace amgcl {
 namespace detail {
 
 //---------------------------------------------------------------------------
-// Adapt backend::crs<> for use with Boost Graph Library.
+// Parallel graph coloring (Jones-Plassmann).
+//
+// The graph is given by the nonzero pattern of A + A^T. In each round every
+// uncolored vertex with the largest weight among its uncolored neighbours
+// receives the smallest color not taken by its neighbours. The vertices
+// colored in a round form an independent set, so the rounds are processed in
+// parallel. The result does not depend on the number of threads.
+//
+// Returns the number of colors.
 //---------------------------------------------------------------------------
 template <class Matrix>
-struct graph {
-    const Matrix &A;
+int parallel_coloring(const Matrix &A, std::vector<int> &color) {
+    const ptrdiff_t n = backend::rows(A);
 
-    typedef typename Matrix::col_type vertex_descriptor;
-    typedef typename Matrix::ptr_type edge_descriptor;
-    typedef boost::directed_tag directed_category;
-    typedef boost::allow_parallel_edge_tag edge_parallel_category;
+    // Symmetric adjacency without the diagonal.
+    std::vector<ptrdiff_t> ptr(n + 1, 0);
 
-    class traversal_category:
-        public boost::incidence_graph_tag,
-        public boost::adjacency_graph_tag,
-        public boost::vertex_list_graph_tag,
-        public boost::edge_list_graph_tag
-    {};
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+            ptrdiff_t c = A.col[j];
+            if (c == i) continue;
 
-    typedef boost::counting_iterator<vertex_descriptor> vertex_iterator;
-    typedef vertex_descriptor vertices_size_type;
+            ++ptr[i + 1];
+            ++ptr[c + 1];
+        }
+    }
 
-    typedef typename std::vector<vertex_descriptor>::const_iterator adjacency_iterator;
+    boost::partial_sum(ptr, ptr.begin());
 
-    static vertex_descriptor null_vertex() { return -1; }
+    std::vector<ptrdiff_t> col(ptr.back());
 
-    graph(const Matrix &A) : A(A) {}
-};
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+            ptrdiff_t c = A.col[j];
+            if (c == i) continue;
 
-template <class Matrix>
-std::pair<
-    typename graph<Matrix>::vertex_iterator,
-    typename graph<Matrix>::vertex_iterator
-    >
-vertices(const graph<Matrix> &G) {
-    return std::make_pair(
-            boost::counting_iterator<typename graph<Matrix>::vertex_descriptor>(0),
-            boost::counting_iterator<typename graph<Matrix>::vertex_descriptor>(backend::rows(G.A))
-            );
-}
+            col[ptr[i]++] = c;
+            col[ptr[c]++] = i;
+        }
+    }
 
-template <class Matrix>
-std::pair<
-    typename graph<Matrix>::adjacency_iterator,
-    typename graph<Matrix>::adjacency_iterator
-    >
-adjacent_vertices(ptrdiff_t v, const graph<Matrix> &G) {
-    typename Matrix::ptr_type row_beg = G.A.ptr[v];
-    typename Matrix::ptr_type row_end = G.A.ptr[v + 1];
-
-    return std::make_pair(
-            G.A.col.begin() + row_beg,
-            G.A.col.begin() + row_end
-            );
-}
+    std::rotate(ptr.begin(), ptr.end() - 1, ptr.end());
+    ptr.front() = 0;
 
-template <class Matrix>
-typename graph<Matrix>::vertices_size_type
-num_vertices(const graph<Matrix> &G) {
-    return backend::rows(G.A);
-}
+    ptrdiff_t max_degree = 0;
+    for(ptrdiff_t i = 0; i < n; ++i)
+        max_degree = std::max(max_degree, ptr[i + 1] - ptr[i]);
 
-template <class Matrix>
-graph<Matrix> as_graph(const Matrix &A) {
-    return graph<Matrix>(A);
+    std::vector<unsigned> weight(n);
+    std::vector<char>     pick(n);
+
+    color.resize(n);
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        weight[i] = random_weight(i);
+        color[i]  = -1;
+    }
+
+    for(ptrdiff_t left = n; left > 0; ) {
+        // Find the local maxima among uncolored vertices.
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            if (color[i] >= 0) {
+                pick[i] = false;
+                continue;
+            }
+
+            bool is_max = true;
+            for(ptrdiff_t j = ptr[i], e = ptr[i+1]; j < e; ++j) {
+                ptrdiff_t c = col[j];
+
+                if (color[c] < 0 && (weight[c] > weight[i] ||
+                            (weight[c] == weight[i] && c > i)))
+                {
+                    is_max = false;
+                    break;
+                }
+            }
+
+            pick[i] = is_max;
+        }
+
+        // Color the local maxima.
+        ptrdiff_t done = 0;
+
+#pragma omp parallel reduction(+:done)
+        {
+            std::vector<ptrdiff_t> taken(max_degree + 1, -1);
+
+#pragma omp for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (!pick[i]) continue;
+
+                for(ptrdiff_t j = ptr[i], e = ptr[i+1]; j < e; ++j) {
+                    int c = color[col[j]];
+                    if (c >= 0 && c <= max_degree) taken[c] = i;
+                }
+
+                int c = 0;
+                while(taken[c] == i) ++c;
+
+                color[i] = c;
+                ++done;
+            }
+        }
+
+        left -= done;
+    }
+
+    int num_colors = 0;
+    for(ptrdiff_t i = 0; i < n; ++i)
+        num_colors = std::max(num_colors, color[i] + 1);
+
+    return num_colors;
 }
 
 } // namespace detail
 
 namespace relaxation {
 
+/// Multicolor Gauss-Seidel smoother.
+/**
+ * The rows of the matrix are colored in parallel, so that rows of the same
+ * color are not coupled with each other. A copy of the matrix is stored
+ * grouped by color, and each color is updated in parallel in a single sweep
+ * over contiguous memory.
+ *
+ * \param Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ */
 template <class Backend>
 struct multicolor_gauss_seidel {
+    typedef typename Backend::value_type value_type;
+
     struct params {
         params() {}
         params(const boost::property_tree::ptree&) {}
@@ -125,51 +192,116 @@ struct multicolor_gauss_seidel {
             const params&,
             const typename Backend::params&
             )
-        : color(backend::rows(A))
     {
-        num_colors = boost::sequential_vertex_coloring(detail::as_graph(A), color.data());
+        const ptrdiff_t n = backend::rows(A);
+
+        std::vector<int> color;
+        num_colors = amgcl::detail::parallel_coloring(A, color);
+
+        // Sort rows by color.
+        start.resize(num_colors + 1, 0);
+
+        for(ptrdiff_t i = 0; i < n; ++i)
+            ++start[color[i] + 1];
+
+        boost::partial_sum(start, start.begin());
+
+        order.resize(n);
+        {
+            std::vector<ptrdiff_t> head(start.begin(), start.end() - 1);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                order[head[color[i]]++] = i;
+        }
+
+        // Copy off-diagonal entries of the matrix in color order, and
+        // keep the inverted diagonal separately.
+        ptr.resize(n + 1);
+        ptr[0] = 0;
+
+        for(ptrdiff_t r = 0; r < n; ++r) {
+            ptrdiff_t i = order[r];
+            ptr[r + 1] = ptr[r];
+
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                if (A.col[j] != i) ++ptr[r + 1];
+        }
+
+        col.resize(ptr.back());
+        val.resize(ptr.back());
+        dia.resize(n);
+
+#pragma omp parallel for
+        for(ptrdiff_t r = 0; r < n; ++r) {
+            ptrdiff_t  i = order[r];
+            ptrdiff_t  h = ptr[r];
+            value_type d = 1;
+
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                if (A.col[j] == i) {
+                    d = A.val[j];
+                } else {
+                    col[h] = A.col[j];
+                    val[h] = A.val[j];
+                    ++h;
+                }
+            }
+
+            dia[r] = 1 / d;
+        }
     }
 
     template <class Matrix, class VecRHS, class VecX, class VecTMP>
-    void apply_pre(const Matrix &A, const VecRHS &rhs, VecX &x, VecTMP&, const params&) const
+    void apply_pre(const Matrix&, const VecRHS &rhs, VecX &x, VecTMP&, const params&) const
     {
-        for(int c = 0; c < num_colors; ++c) iterate(A, rhs, x, c);
+        for(int c = 0; c < num_colors; ++c) iterate(rhs, x, c);
     }
 
     template <class Matrix, class VecRHS, class VecX, class VecTMP>
-    void apply_post(const Matrix &A, const VecRHS &rhs, VecX &x, VecTMP&, const params&) const
+    void apply_post(const Matrix&, const VecRHS &rhs, VecX &x, VecTMP&, const params&) const
     {
-        for(int c = num_colors; c --> 0; ) iterate(A, rhs, x, c);
+        for(int c = num_colors; c --> 0; ) iterate(rhs, x, c);
+    }
+
+    /// Number of colors used by the smoother.
+    int colors() const {
+        return num_colors;
     }
 
     private:
         int num_colors;
-        std::vector<int> color;
 
-        template <class Matrix, class VectorRHS, class VectorX>
-        static void iterate(
-                const Matrix &A, const VectorRHS &rhs, VectorX &x, int c)
-        {
-            typedef typename backend::row_iterator<Matrix>::type row_iterator;
-            typedef typename backend::value_type<Matrix>::type val_type;
+        std::vector<ptrdiff_t>  start;
+        std::vector<ptrdiff_t>  order;
+        std::vector<ptrdiff_t>  ptr;
+        std::vector<ptrdiff_t>  col;
+        std::vector<value_type> val;
+        std::vector<value_type> dia;
 
-            const size_t n = backend::rows(A);
+        template <class VectorRHS, class VectorX>
+        void iterate(const VectorRHS &rhs, VectorX &x, int c) const
+        {
+            const ptrdiff_t beg = start[c];
+            const ptrdiff_t end = start[c + 1];
 
 #pragma omp parallel for
-            for(size_t i = 0; i < n; ++i) {
-                val_type temp = rhs[i];
-                val_type diag = 1;
-                for (row_iterator a = backend::row_begin(A, i); a; ++a) {
-                    if (static_cast<size_t>(a.col()) == i)
-                        diag = a.value();
-                    else
-                        temp -= a.value() * x[a.col()];
-                }
-                x[i] = temp / diag;
+            for(ptrdiff_t r = beg; r < end; ++r) {
+                ptrdiff_t  i    = order[r];
+                value_type temp = rhs[i];
+
+                for(ptrdiff_t j = ptr[r], e = ptr[r + 1]; j < e; ++j)
+                    temp -= val[j] * x[col[j]];
+
+                x[i] = temp * dia[r];
             }
         }
 };
 
+/// Reports the number of colors used by the smoother.
+template <class Backend>
+void print_info(std::ostream &os, const multicolor_gauss_seidel<Backend> &r) {
+    os << "multicolor_gauss_seidel: " << r.colors() << " colors";
+}
+
 } // namespace relaxation
 
 namespace backend {
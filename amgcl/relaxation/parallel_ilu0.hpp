@@ -0,0 +1,310 @@
+#ifndef AMGCL_RELAXATION_PARALLEL_ILU0_HPP
+#define AMGCL_RELAXATION_PARALLEL_ILU0_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/parallel_ilu0.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Fine-grained parallel incomplete LU relaxation scheme.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/range/algorithm.hpp>
+#include <boost/range/numeric.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// Fine-grained parallel ILU(0) smoother.
+/**
+ * The ILU(0) factors are computed with a number of fixed-point sweeps over
+ * all nonzero entries of the factors. Each sweep updates every entry
+ * independently from the values of the previous sweep, so both the sweep and
+ * the result are independent of the number of threads. The triangular solves
+ * are replaced with a fixed number of Jacobi iterations. As a result, both
+ * setup and application of the smoother are fully parallel, and the
+ * application only uses the backend operations (sparse matrix-vector products
+ * and vector updates).
+ *
+ * \param Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ * \sa \cite Chow2015
+ */
+template <class Backend>
+struct parallel_ilu0 {
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::matrix     matrix;
+    typedef typename Backend::vector     vector;
+
+    /// Relaxation parameters.
+    struct params {
+        /// Damping factor.
+        float damping;
+
+        /// Number of fixed-point sweeps for the factorization.
+        unsigned sweeps;
+
+        /// Number of Jacobi iterations per triangular solve.
+        unsigned jacobi_iters;
+
+        params(float damping = 0.72, unsigned sweeps = 2, unsigned jacobi_iters = 2)
+            : damping(damping), sweeps(sweeps), jacobi_iters(jacobi_iters) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, damping),
+              AMGCL_PARAMS_IMPORT_VALUE(p, sweeps),
+              AMGCL_PARAMS_IMPORT_VALUE(p, jacobi_iters)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, damping);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, sweeps);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, jacobi_iters);
+        }
+    };
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+    template <class Matrix>
+    parallel_ilu0( const Matrix &A, const params &prm, const typename Backend::params &backend_prm)
+        : t1( Backend::create_vector(backend::rows(A), backend_prm) ),
+          t2( Backend::create_vector(backend::rows(A), backend_prm) ),
+          t3( Backend::create_vector(backend::rows(A), backend_prm) )
+    {
+        const ptrdiff_t n   = backend::rows(A);
+        const ptrdiff_t nnz = backend::nonzeros(A);
+        const value_type eps = amgcl::detail::eps<value_type>(1);
+
+        std::vector<ptrdiff_t> dia(n, -1);
+
+        // Position of the diagonal in each row.
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                if (A.col[j] == i) {
+                    dia[i] = j;
+                    break;
+                }
+            }
+        }
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            precondition(dia[i] >= 0, "No diagonal value in system matrix");
+            precondition(fabs(A.val[dia[i]]) > eps, "Zero pivot in ILU");
+        }
+
+        // Columns of the upper factor (including the diagonal). For each
+        // entry we keep its row number and its position in A. Rows are
+        // sorted within each column.
+        std::vector<ptrdiff_t> ut_ptr(n + 1, 0);
+
+        for(ptrdiff_t i = 0; i < n; ++i)
+            for(ptrdiff_t j = dia[i], e = A.ptr[i+1]; j < e; ++j)
+                ++ut_ptr[A.col[j] + 1];
+
+        boost::partial_sum(ut_ptr, ut_ptr.begin());
+
+        std::vector<ptrdiff_t> ut_row(ut_ptr.back());
+        std::vector<ptrdiff_t> ut_pos(ut_ptr.back());
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(ptrdiff_t j = dia[i], e = A.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t head = ut_ptr[A.col[j]]++;
+                ut_row[head] = i;
+                ut_pos[head] = j;
+            }
+        }
+
+        std::rotate(ut_ptr.begin(), ut_ptr.end() - 1, ut_ptr.end());
+        ut_ptr.front() = 0;
+
+        // Initial approximation: L = tril(A) D^-1, U = triu(A).
+        std::vector<value_type> lu(nnz), lu_new(nnz);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t c = A.col[j];
+                lu[j] = (c < i) ? A.val[j] / A.val[dia[c]] : A.val[j];
+            }
+        }
+
+        // Fixed-point sweeps.
+        for(unsigned sweep = 0; sweep < prm.sweeps; ++sweep) {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    ptrdiff_t m = std::min(i, c);
+
+                    // s = a_ij - sum_{k < min(i,j)} l_ik u_kj
+                    value_type s = A.val[j];
+
+                    for(
+                            ptrdiff_t jl = A.ptr[i], el = dia[i],
+                            ju = ut_ptr[c], eu = ut_ptr[c+1];
+                            jl < el && ju < eu;
+                       )
+                    {
+                        ptrdiff_t kl = A.col[jl];
+                        ptrdiff_t ku = ut_row[ju];
+
+                        if (kl >= m || ku >= m) break;
+
+                        if (kl < ku) {
+                            ++jl;
+                        } else if (ku < kl) {
+                            ++ju;
+                        } else {
+                            s -= lu[jl] * lu[ut_pos[ju]];
+                            ++jl;
+                            ++ju;
+                        }
+                    }
+
+                    lu_new[j] = (c < i) ? s / lu[dia[c]] : s;
+                }
+            }
+
+            lu.swap(lu_new);
+        }
+
+        // Split the factors into strictly lower/upper parts and the inverted
+        // diagonal, and move them to the backend.
+        boost::shared_ptr<build_matrix> Lf = boost::make_shared<build_matrix>();
+        boost::shared_ptr<build_matrix> Uf = boost::make_shared<build_matrix>();
+        std::vector<value_type> D(n);
+
+        Lf->nrows = Lf->ncols = n;
+        Uf->nrows = Uf->ncols = n;
+
+        Lf->ptr.resize(n + 1, 0);
+        Uf->ptr.resize(n + 1, 0);
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            Lf->ptr[i + 1] = Lf->ptr[i] + dia[i] - A.ptr[i];
+            Uf->ptr[i + 1] = Uf->ptr[i] + A.ptr[i + 1] - dia[i] - 1;
+        }
+
+        Lf->col.resize(Lf->ptr.back());
+        Lf->val.resize(Lf->ptr.back());
+        Uf->col.resize(Uf->ptr.back());
+        Uf->val.resize(Uf->ptr.back());
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t l = Lf->ptr[i];
+            ptrdiff_t u = Uf->ptr[i];
+
+            for(ptrdiff_t j = A.ptr[i]; j < dia[i]; ++j, ++l) {
+                Lf->col[l] = A.col[j];
+                Lf->val[l] = lu[j];
+            }
+
+            D[i] = 1 / lu[dia[i]];
+
+            for(ptrdiff_t j = dia[i] + 1; j < A.ptr[i + 1]; ++j, ++u) {
+                Uf->col[u] = A.col[j];
+                Uf->val[u] = lu[j];
+            }
+        }
+
+        L    = Backend::copy_matrix(Lf, backend_prm);
+        U    = Backend::copy_matrix(Uf, backend_prm);
+        Dinv = Backend::copy_vector(D, backend_prm);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm
+            ) const
+    {
+        apply(A, rhs, x, tmp, prm);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params &prm
+            ) const
+    {
+        apply(A, rhs, x, tmp, prm);
+    }
+
+    private:
+        typedef typename backend::builtin<value_type>::matrix build_matrix;
+
+        boost::shared_ptr<matrix> L, U;
+        boost::shared_ptr<vector> Dinv;
+        mutable boost::shared_ptr<vector> t1, t2, t3;
+
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                const params &prm
+                ) const
+        {
+            backend::residual(rhs, A, x, tmp);
+
+            // Solve L y = r with Jacobi iterations: y <- r - L y.
+            vector *y0 = t1.get();
+            vector *y1 = t2.get();
+
+            backend::copy(tmp, *y0);
+            for(unsigned k = 0; k < prm.jacobi_iters; ++k) {
+                backend::residual(tmp, *L, *y0, *y1);
+                std::swap(y0, y1);
+            }
+
+            // Solve U z = y with Jacobi iterations: z <- D^-1 (y - U z).
+            vector *z0 = y1;
+            vector *z1 = t3.get();
+
+            backend::vmul(1, *Dinv, *y0, 0, *z0);
+            for(unsigned k = 0; k < prm.jacobi_iters; ++k) {
+                backend::residual(*y0, *U, *z0, *z1);
+                backend::vmul(1, *Dinv, *z1, 0, *z1);
+                std::swap(z0, z1);
+            }
+
+            backend::axpby(prm.damping, *z0, 1, x);
+        }
+};
+
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
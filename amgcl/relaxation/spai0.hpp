@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 #include <boost/shared_ptr.hpp>
 #include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/interface.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -105,6 +106,21 @@ struct spai0 {
         apply(A, rhs, x, tmp);
     }
 
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre_and_residual
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre_and_residual(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&, bool zero_x
+            ) const
+    {
+        if (zero_x)
+            backend::vmul(1, *M, rhs, 0, x);
+        else
+            apply(A, rhs, x, tmp);
+
+        backend::residual(rhs, A, x, tmp);
+    }
+
     private:
         boost::shared_ptr<vector> M;
 
@@ -119,6 +135,11 @@ struct spai0 {
 
 };
 
+template <class Backend>
+struct provides_apply_pre_and_residual< spai0<Backend> >
+    : boost::true_type
+{};
+
 } // namespace relaxation
 } // namespace amgcl
 
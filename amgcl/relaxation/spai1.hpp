@@ -32,14 +32,11 @@ THE SOFTWARE.
  */
 
 #include <vector>
-#ifdef _OPENMP
-#  include <omp.h>
-#endif
 
 #include <boost/shared_ptr.hpp>
 #include <amgcl/backend/interface.hpp>
 #include <amgcl/util.hpp>
-#include <amgcl/detail/qr.hpp>
+#include <amgcl/relaxation/detail/spai.hpp>
 
 namespace amgcl {
 namespace relaxation {
@@ -68,79 +65,14 @@ struct spai1 {
     template <class Matrix>
     spai1( const Matrix &A, const params &, const typename Backend::params &backend_prm)
     {
-        typedef typename backend::value_type<Matrix>::type   value_type;
-        typedef typename backend::row_iterator<Matrix>::type row_iterator;
-
-        const size_t n = rows(A);
-        const size_t m = cols(A);
-
         boost::shared_ptr<Matrix> Ainv = boost::make_shared<Matrix>();
-        Ainv->nrows = n;
-        Ainv->ncols = m;
+        Ainv->nrows = rows(A);
+        Ainv->ncols = cols(A);
 
         Ainv->ptr = A.ptr;
         Ainv->col = A.col;
-        Ainv->val.assign(A.ptr.back(), 0);
 
-#pragma omp parallel
-        {
-#ifdef _OPENMP
-            int nt  = omp_get_num_threads();
-            int tid = omp_get_thread_num();
-
-            size_t chunk_size  = (n + nt - 1) / nt;
-            size_t chunk_start = tid * chunk_size;
-            size_t chunk_end   = std::min(n, chunk_start + chunk_size);
-#else
-            size_t chunk_start = 0;
-            size_t chunk_end   = n;
-#endif
-
-            std::vector<ptrdiff_t> marker(m, -1);
-            std::vector<ptrdiff_t> I, J;
-            std::vector<value_type> B, ek;
-            amgcl::detail::QR<value_type> qr;
-
-            for(size_t i = chunk_start; i < chunk_end; ++i) {
-                ptrdiff_t row_beg = A.ptr[i];
-                ptrdiff_t row_end = A.ptr[i + 1];
-
-                I.assign(A.col.begin() + row_beg, A.col.begin() + row_end);
-
-                J.clear();
-                for(ptrdiff_t j = row_beg; j < row_end; ++j) {
-                    ptrdiff_t c = A.col[j];
-
-                    for(ptrdiff_t jj = A.ptr[c], ee = A.ptr[c + 1]; jj < ee; ++jj) {
-                        ptrdiff_t cc = A.col[jj];
-                        if (marker[cc] < 0) {
-                            marker[cc] = 1;
-                            J.push_back(cc);
-                        }
-                    }
-                }
-                std::sort(J.begin(), J.end());
-                B.assign(I.size() * J.size(), 0);
-                ek.assign(J.size(), 0);
-                for(size_t j = 0; j < J.size(); ++j) {
-                    marker[J[j]] = j;
-                    if (J[j] == static_cast<ptrdiff_t>(i)) ek[j] = 1;
-                }
-
-                for(ptrdiff_t j = row_beg; j < row_end; ++j) {
-                    ptrdiff_t c = A.col[j];
-
-                    for(row_iterator a = row_begin(A, c); a; ++a)
-                        B[marker[a.col()] * I.size() + j - row_beg] = a.value();
-                }
-
-                qr.compute(J.size(), I.size(), B.data(), /*need Q: */false);
-                qr.solve(ek.data(), &Ainv->val[row_beg]);
-
-                for(size_t j = 0; j < J.size(); ++j)
-                    marker[J[j]] = -1;
-            }
-        }
+        detail::spai_values(A, *Ainv);
 
         M = Backend::copy_matrix(Ainv, backend_prm);
     }
@@ -0,0 +1,317 @@
+#ifndef AMGCL_RELAXATION_SPAI_THRESHOLD_HPP
+#define AMGCL_RELAXATION_SPAI_THRESHOLD_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/spai_threshold.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Sparse approximate inverse with a priori thresholded pattern.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <iostream>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/range/numeric.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/relaxation/interface.hpp>
+#include <amgcl/relaxation/detail/spai.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// Sparse approximate inverse smoother with thresholded pattern.
+/**
+ * The sparsity pattern of the approximate inverse is taken from the power
+ * (\f$A\f$ or \f$A^2\f$) of the sparsified system matrix, where the weak
+ * entries \f$|a_{ij}| < \tau \sqrt{|a_{ii} a_{jj}|}\f$ are dropped. The
+ * number of nonzeros in each row of the pattern may be further limited, in
+ * which case only the largest entries of the power are kept. The values are
+ * found from independent least-squares problems in parallel, and the
+ * smoother is applied as a single matrix-vector product, so that it may be
+ * used with any backend.
+ *
+ * The smoother is tunable between amgcl::relaxation::spai0 (with large
+ * thresholds, only the diagonal remains) and amgcl::relaxation::spai1 (with
+ * zero threshold and the first power of the matrix).
+ *
+ * \tparam Backend Backend for temporary structures allocation.
+ * \ingroup relaxation
+ * \sa \cite Chow2000, \cite Broker2002
+ */
+template <class Backend>
+struct spai_threshold {
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::vector     vector;
+
+    /// Relaxation parameters.
+    struct params {
+        /// Power of the sparsified matrix that defines the pattern (1 or 2).
+        int power;
+
+        /// Relative threshold for dropping weak entries of the matrix.
+        float threshold;
+
+        /// Maximum number of nonzeros per row of the inverse (0 means no limit).
+        int max_row_nnz;
+
+        params(int power = 1, float threshold = 0.01f, int max_row_nnz = 0)
+            : power(power), threshold(threshold), max_row_nnz(max_row_nnz) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, power),
+              AMGCL_PARAMS_IMPORT_VALUE(p, threshold),
+              AMGCL_PARAMS_IMPORT_VALUE(p, max_row_nnz)
+        {}
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, power);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, threshold);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, max_row_nnz);
+        }
+    };
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+    template <class Matrix>
+    spai_threshold( const Matrix &A, const params &prm, const typename Backend::params &backend_prm)
+    {
+        typedef typename backend::row_iterator<Matrix>::type row_iterator;
+
+        precondition(prm.power == 1 || prm.power == 2,
+                "spai_threshold: power should be either 1 or 2");
+
+        const ptrdiff_t n = backend::rows(A);
+
+        // Sparsified matrix.
+        std::vector<value_type> dia(n, 0);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(row_iterator a = backend::row_begin(A, i); a; ++a) {
+                if (a.col() == i) {
+                    dia[i] = std::fabs(a.value());
+                    break;
+                }
+            }
+        }
+
+        build_matrix S;
+        S.nrows = S.ncols = n;
+        S.ptr.resize(n + 1, 0);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(row_iterator a = backend::row_begin(A, i); a; ++a)
+                if (strong(prm, dia, i, a.col(), a.value())) ++S.ptr[i + 1];
+        }
+
+        boost::partial_sum(S.ptr, S.ptr.begin());
+        S.col.resize(S.ptr.back());
+        S.val.resize(S.ptr.back());
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t head = S.ptr[i];
+            for(row_iterator a = backend::row_begin(A, i); a; ++a) {
+                if (strong(prm, dia, i, a.col(), a.value())) {
+                    S.col[head] = a.col();
+                    S.val[head] = std::fabs(a.value());
+                    ++head;
+                }
+            }
+        }
+
+        // Pattern of the approximate inverse.
+        boost::shared_ptr<build_matrix> Ainv = boost::make_shared<build_matrix>();
+        Ainv->nrows = Ainv->ncols = n;
+        Ainv->ptr.resize(n + 1, 0);
+
+        std::vector< std::vector<ptrdiff_t> > cols(n);
+
+#pragma omp parallel
+        {
+            std::vector<value_type> w(n, 0);
+            std::vector<ptrdiff_t>  marker(n, -1);
+            std::vector<ptrdiff_t>  nz;
+
+#pragma omp for schedule(dynamic, 64)
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                pattern(S, prm, i, w, marker, nz);
+                cols[i].assign(nz.begin(), nz.end());
+                Ainv->ptr[i + 1] = nz.size();
+            }
+        }
+
+        boost::partial_sum(Ainv->ptr, Ainv->ptr.begin());
+        Ainv->col.resize(Ainv->ptr.back());
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            std::copy(cols[i].begin(), cols[i].end(), Ainv->col.begin() + Ainv->ptr[i]);
+            std::vector<ptrdiff_t>().swap(cols[i]);
+        }
+
+        detail::spai_values(A, *Ainv);
+
+        m_nonzeros = Ainv->ptr.back();
+        M = Backend::copy_matrix(Ainv, backend_prm);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&
+            ) const
+    {
+        backend::residual(rhs, A, x, tmp);
+        backend::spmv(1, *M, tmp, 1, x);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&
+            ) const
+    {
+        backend::residual(rhs, A, x, tmp);
+        backend::spmv(1, *M, tmp, 1, x);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre_and_residual
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre_and_residual(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+            const params&, bool zero_x
+            ) const
+    {
+        if (zero_x) {
+            backend::spmv(1, *M, rhs, 0, x);
+        } else {
+            backend::residual(rhs, A, x, tmp);
+            backend::spmv(1, *M, tmp, 1, x);
+        }
+
+        backend::residual(rhs, A, x, tmp);
+    }
+
+    /// Number of nonzeros in the approximate inverse.
+    size_t nonzeros() const {
+        return m_nonzeros;
+    }
+
+    private:
+        typedef typename backend::builtin<value_type>::matrix build_matrix;
+
+        boost::shared_ptr<typename Backend::matrix> M;
+        size_t m_nonzeros;
+
+        static bool strong(const params &prm, const std::vector<value_type> &dia,
+                ptrdiff_t i, ptrdiff_t j, value_type v)
+        {
+            return i == j || std::fabs(v) >= prm.threshold * std::sqrt(dia[i] * dia[j]);
+        }
+
+        // Sorted pattern of the i-th row of the inverse. The entries are
+        // weighted with the absolute values of S (or S^2), and the largest
+        // ones are kept when the number of nonzeros is limited.
+        static void pattern(const build_matrix &S, const params &prm,
+                ptrdiff_t i, std::vector<value_type> &w,
+                std::vector<ptrdiff_t> &marker, std::vector<ptrdiff_t> &nz)
+        {
+            nz.clear();
+
+            for(ptrdiff_t j = S.ptr[i], e = S.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t  c = S.col[j];
+                value_type v = S.val[j];
+
+                if (prm.power == 1) {
+                    nz.push_back(c);
+                    w[c] = v;
+                    continue;
+                }
+
+                for(ptrdiff_t jj = S.ptr[c], ee = S.ptr[c+1]; jj < ee; ++jj) {
+                    ptrdiff_t cc = S.col[jj];
+                    if (marker[cc] != i) {
+                        marker[cc] = i;
+                        nz.push_back(cc);
+                    }
+                    w[cc] += v * S.val[jj];
+                }
+            }
+
+            if (prm.max_row_nnz > 0 && nz.size() > static_cast<size_t>(prm.max_row_nnz)) {
+                // The diagonal is always kept.
+                w[i] = std::numeric_limits<value_type>::max();
+
+                std::nth_element(nz.begin(), nz.begin() + prm.max_row_nnz - 1, nz.end(),
+                        by_weight(w));
+
+                for(std::vector<ptrdiff_t>::const_iterator c = nz.begin() + prm.max_row_nnz; c != nz.end(); ++c)
+                    w[*c] = 0;
+
+                nz.resize(prm.max_row_nnz);
+            }
+
+            std::sort(nz.begin(), nz.end());
+
+            for(std::vector<ptrdiff_t>::const_iterator c = nz.begin(); c != nz.end(); ++c)
+                w[*c] = 0;
+        }
+
+        struct by_weight {
+            const std::vector<value_type> &w;
+
+            by_weight(const std::vector<value_type> &w) : w(w) {}
+
+            bool operator()(ptrdiff_t a, ptrdiff_t b) const {
+                return w[a] > w[b];
+            }
+        };
+};
+
+template <class Backend>
+struct provides_apply_pre_and_residual< spai_threshold<Backend> >
+    : boost::true_type
+{};
+
+/// Reports the size of the approximate inverse.
+template <class Backend>
+void print_info(std::ostream &os, const spai_threshold<Backend> &r) {
+    os << "spai_threshold: nnz(M) = " << r.nonzeros();
+}
+
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
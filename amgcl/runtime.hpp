@@ -32,13 +32,22 @@ THE SOFTWARE.
  */
 
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
+#include <cmath>
 
 #include <boost/type_traits.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
 
 #include <amgcl/amgcl.hpp>
+#include <amgcl/clock.hpp>
 
 #include <amgcl/backend/interface.hpp>
 #include <amgcl/coarsening/ruge_stuben.hpp>
@@ -46,6 +55,7 @@ THE SOFTWARE.
 #include <amgcl/coarsening/aggregation.hpp>
 #include <amgcl/coarsening/smoothed_aggregation.hpp>
 #include <amgcl/coarsening/smoothed_aggr_emin.hpp>
+#include <amgcl/coarsening/pairwise_aggregates.hpp>
 
 #include <amgcl/relaxation/gauss_seidel.hpp>
 #include <amgcl/relaxation/multicolor_gauss_seidel.hpp>
@@ -54,6 +64,12 @@ THE SOFTWARE.
 #include <amgcl/relaxation/spai0.hpp>
 #include <amgcl/relaxation/spai1.hpp>
 #include <amgcl/relaxation/chebyshev.hpp>
+#include <amgcl/relaxation/parallel_ilu0.hpp>
+#include <amgcl/relaxation/iluk.hpp>
+#include <amgcl/relaxation/ilut.hpp>
+#include <amgcl/relaxation/hybrid_gauss_seidel.hpp>
+#include <amgcl/relaxation/l1_jacobi.hpp>
+#include <amgcl/relaxation/spai_threshold.hpp>
 
 #include <amgcl/solver/cg.hpp>
 #include <amgcl/solver/bicgstab.hpp>
@@ -72,7 +88,8 @@ enum type {
     ruge_stuben,
     aggregation,
     smoothed_aggregation,
-    smoothed_aggr_emin
+    smoothed_aggr_emin,
+    pairwise_aggregation
 };
 
 inline std::ostream& operator<<(std::ostream &os, type c) {
@@ -85,6 +102,8 @@ inline std::ostream& operator<<(std::ostream &os, type c) {
             return os << "smoothed_aggregation";
         case smoothed_aggr_emin:
             return os << "smoothed_aggr_emin";
+        case pairwise_aggregation:
+            return os << "pairwise_aggregation";
         default:
             return os << "???";
     }
@@ -103,6 +122,8 @@ inline std::istream& operator>>(std::istream &in, type &c)
         c = smoothed_aggregation;
     else if (val == "smoothed_aggr_emin")
         c = smoothed_aggr_emin;
+    else if (val == "pairwise_aggregation")
+        c = pairwise_aggregation;
     else
         throw std::invalid_argument("Invalid coarsening value");
 
@@ -120,7 +141,14 @@ enum type {
     damped_jacobi,
     spai0,
     spai1,
-    chebyshev
+    chebyshev,
+    parallel_ilu0,
+    iluk,
+    ilut,
+    hybrid_gauss_seidel,
+    l1_jacobi,
+    spai_threshold,
+    per_level
 };
 
 inline std::ostream& operator<<(std::ostream &os, type r)
@@ -140,6 +168,20 @@ inline std::ostream& operator<<(std::ostream &os, type r)
             return os << "spai1";
         case chebyshev:
             return os << "chebyshev";
+        case parallel_ilu0:
+            return os << "parallel_ilu0";
+        case iluk:
+            return os << "iluk";
+        case ilut:
+            return os << "ilut";
+        case hybrid_gauss_seidel:
+            return os << "hybrid_gauss_seidel";
+        case l1_jacobi:
+            return os << "l1_jacobi";
+        case spai_threshold:
+            return os << "spai_threshold";
+        case per_level:
+            return os << "per_level";
         default:
             return os << "???";
     }
@@ -164,6 +206,20 @@ inline std::istream& operator>>(std::istream &in, type &r)
         r = spai1;
     else if (val == "chebyshev")
         r = chebyshev;
+    else if (val == "parallel_ilu0")
+        r = parallel_ilu0;
+    else if (val == "iluk")
+        r = iluk;
+    else if (val == "ilut")
+        r = ilut;
+    else if (val == "hybrid_gauss_seidel")
+        r = hybrid_gauss_seidel;
+    else if (val == "l1_jacobi")
+        r = l1_jacobi;
+    else if (val == "spai_threshold")
+        r = spai_threshold;
+    else if (val == "per_level")
+        r = per_level;
     else
         throw std::invalid_argument("Invalid relaxation value");
 
@@ -220,6 +276,465 @@ inline std::istream& operator>>(std::istream &in, type &s)
 
 namespace detail {
 
+//---------------------------------------------------------------------------
+template <
+    class Backend,
+    template <class> class Relaxation,
+    class Func
+    >
+inline
+typename boost::enable_if<
+    typename backend::relaxation_is_supported<Backend, Relaxation>::type,
+    void
+>::type
+process_relaxation(const Func &func) {
+    func.template process<Relaxation>();
+}
+
+template <
+    class Backend,
+    template <class> class Relaxation,
+    class Func
+    >
+inline
+typename boost::disable_if<
+    typename backend::relaxation_is_supported<Backend, Relaxation>::type,
+    void
+>::type
+process_relaxation(const Func&) {
+    throw std::logic_error("The relaxation scheme is not supported by the backend");
+}
+
+//---------------------------------------------------------------------------
+template <
+    class Backend,
+    class Func
+    >
+inline void process_relaxation(
+        runtime::relaxation::type relaxation,
+        const Func &func
+        )
+{
+    switch (relaxation) {
+        case runtime::relaxation::gauss_seidel:
+            process_relaxation<Backend, amgcl::relaxation::gauss_seidel>(func);
+            break;
+        case runtime::relaxation::multicolor_gauss_seidel:
+            process_relaxation<Backend, amgcl::relaxation::multicolor_gauss_seidel>(func);
+            break;
+        case runtime::relaxation::ilu0:
+            process_relaxation<Backend, amgcl::relaxation::ilu0>(func);
+            break;
+        case runtime::relaxation::damped_jacobi:
+            process_relaxation<Backend, amgcl::relaxation::damped_jacobi>(func);
+            break;
+        case runtime::relaxation::spai0:
+            process_relaxation<Backend, amgcl::relaxation::spai0>(func);
+            break;
+        case runtime::relaxation::spai1:
+            process_relaxation<Backend, amgcl::relaxation::spai1>(func);
+            break;
+        case runtime::relaxation::chebyshev:
+            process_relaxation<Backend, amgcl::relaxation::chebyshev>(func);
+            break;
+        case runtime::relaxation::parallel_ilu0:
+            process_relaxation<Backend, amgcl::relaxation::parallel_ilu0>(func);
+            break;
+        case runtime::relaxation::iluk:
+            process_relaxation<Backend, amgcl::relaxation::iluk>(func);
+            break;
+        case runtime::relaxation::ilut:
+            process_relaxation<Backend, amgcl::relaxation::ilut>(func);
+            break;
+        case runtime::relaxation::hybrid_gauss_seidel:
+            process_relaxation<Backend, amgcl::relaxation::hybrid_gauss_seidel>(func);
+            break;
+        case runtime::relaxation::l1_jacobi:
+            process_relaxation<Backend, amgcl::relaxation::l1_jacobi>(func);
+            break;
+        case runtime::relaxation::spai_threshold:
+            process_relaxation<Backend, amgcl::relaxation::spai_threshold>(func);
+            break;
+        case runtime::relaxation::per_level:
+            throw std::invalid_argument("Nested per_level relaxation is not supported");
+    }
+}
+
+// Relaxation instance together with its parameters.
+template <class Backend, template <class> class Relaxation>
+struct relaxation_holder {
+    typedef Relaxation<Backend> relax_type;
+
+    typename relax_type::params prm;
+    relax_type relax;
+
+    template <class Matrix>
+    relaxation_holder(
+            const Matrix &A, const boost::property_tree::ptree &p,
+            const typename Backend::params &backend_prm
+            ) : prm(p), relax(A, prm, backend_prm)
+    {}
+};
+
+template <class Backend, class Matrix>
+struct relaxation_create {
+    boost::shared_ptr<void> &handle;
+
+    const Matrix &A;
+    const boost::property_tree::ptree &p;
+    const typename Backend::params &backend_prm;
+
+    relaxation_create(
+            boost::shared_ptr<void> &handle, const Matrix &A,
+            const boost::property_tree::ptree &p,
+            const typename Backend::params &backend_prm
+            ) : handle(handle), A(A), p(p), backend_prm(backend_prm) {}
+
+    template <template <class> class Relaxation>
+    void process() const {
+        handle = boost::make_shared< relaxation_holder<Backend, Relaxation> >(
+                A, p, backend_prm);
+    }
+};
+
+template <class Backend, class Matrix, class Vec1, class Vec2, class Vec3>
+struct relaxation_apply {
+    void *handle;
+
+    const Matrix &A;
+    const Vec1   &rhs;
+    Vec2         &x;
+    Vec3         &tmp;
+
+    bool     pre;
+    unsigned sweeps;
+
+    relaxation_apply(
+            void *handle, const Matrix &A, const Vec1 &rhs, Vec2 &x, Vec3 &tmp,
+            bool pre, unsigned sweeps
+            ) : handle(handle), A(A), rhs(rhs), x(x), tmp(tmp),
+                pre(pre), sweeps(sweeps) {}
+
+    template <template <class> class Relaxation>
+    void process() const {
+        const relaxation_holder<Backend, Relaxation> *h =
+            static_cast<const relaxation_holder<Backend, Relaxation>*>(handle);
+
+        for(unsigned i = 0; i < sweeps; ++i) {
+            if (pre)
+                h->relax.apply_pre(A, rhs, x, tmp, h->prm);
+            else
+                h->relax.apply_post(A, rhs, x, tmp, h->prm);
+        }
+    }
+};
+
+template <class Backend>
+struct relaxation_print {
+    void *handle;
+    std::ostream &os;
+
+    relaxation_print(void *handle, std::ostream &os) : handle(handle), os(os) {}
+
+    template <template <class> class Relaxation>
+    void process() const {
+        using amgcl::relaxation::print_info;
+        print_info(os, static_cast<relaxation_holder<Backend, Relaxation>*>(handle)->relax);
+    }
+};
+
+} // namespace detail
+
+/// Relaxation that is chosen separately for each level of the hierarchy.
+/**
+ * The smoother on each level is one of the schemes from
+ * amgcl::runtime::relaxation with its own parameters and number of pre- and
+ * post-relaxations. The configuration is read from the relaxation parameters:
+ \code
+ {
+     "type" : "spai0",          // Default relaxation.
+     "npre" : 1,                // Default number of pre-relaxations.
+     "npost": 1,                // Default number of post-relaxations.
+     "levels": [                // Explicit configuration for the first levels.
+         { "type": "ilu0", "npre": 1, "npost": 1 },
+         { "type": "damped_jacobi", "damping": 0.8, "npre": 2, "npost": 2 }
+     ],
+     "candidates": [            // Candidates for automatic selection.
+         { "type": "ilu0" },
+         { "type": "spai0", "npre": 2, "npost": 2 }
+     ],
+     "trials": 3                // Number of trial sweeps per candidate.
+ }
+ \endcode
+ * The remaining keys of each entry are passed to the relaxation as its
+ * parameters. Levels that are not covered by the "levels" array are
+ * configured automatically if any candidates are given, and use the
+ * default relaxation otherwise.
+ *
+ * In the automatic mode each candidate is set up on the level and applied
+ * "trials" times to a pseudo-random error (with zero right-hand side). The
+ * candidate with the smallest time per unit of the natural logarithm of the
+ * residual reduction wins. Candidates not supported by the backend are
+ * skipped.
+ *
+ * \note The numbers of relaxations here are multiplied by amgcl::amg::params
+ * npre and npost, which should normally be left at their default values.
+ */
+template <class Backend>
+class per_level_relaxation {
+    public:
+        typedef typename Backend::value_type value_type;
+        typedef typename Backend::vector     vector;
+
+        /// Relaxation parameters.
+        struct params {
+            /// Default relaxation type.
+            runtime::relaxation::type type;
+
+            /// Default number of pre-relaxations.
+            unsigned npre;
+
+            /// Default number of post-relaxations.
+            unsigned npost;
+
+            /// Number of trial sweeps for the automatic selection.
+            unsigned trials;
+
+            /// The complete parameter tree.
+            boost::property_tree::ptree p;
+
+            params()
+                : type(runtime::relaxation::spai0), npre(1), npost(1), trials(3)
+            {}
+
+            params(const boost::property_tree::ptree &p)
+                : type  (p.get("type",   params().type)),
+                  npre  (p.get("npre",   params().npre)),
+                  npost (p.get("npost",  params().npost)),
+                  trials(p.get("trials", params().trials)),
+                  p(p)
+            {}
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                BOOST_FOREACH(const boost::property_tree::ptree::value_type &v, this->p)
+                    p.put_child(path + v.first, v.second);
+
+                p.put(path + "type",   type);
+                p.put(path + "npre",   npre);
+                p.put(path + "npost",  npost);
+                p.put(path + "trials", trials);
+            }
+        };
+
+        /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
+        /**
+         * \param level The level of the hierarchy (zero is the finest one).
+         */
+        template <class Matrix>
+        per_level_relaxation(
+                const Matrix &A, const params &prm,
+                const typename Backend::params &backend_prm,
+                unsigned level = 0
+                ) : cfg(prm.p, prm), automatic(false), rate(0), sweep_time(0)
+        {
+            typedef boost::property_tree::ptree ptree;
+
+            const ptree &levels     = prm.p.get_child("levels",     amgcl::detail::empty_ptree());
+            const ptree &candidates = prm.p.get_child("candidates", amgcl::detail::empty_ptree());
+
+            if (level < levels.size()) {
+                ptree::const_iterator l = levels.begin();
+                std::advance(l, level);
+
+                cfg = config(l->second, prm);
+                detail::process_relaxation<Backend>(cfg.type,
+                        detail::relaxation_create<Backend, Matrix>(
+                            handle, A, cfg.prm, backend_prm));
+            } else if (!candidates.empty()) {
+                select(A, prm, candidates, backend_prm);
+            } else {
+                detail::process_relaxation<Backend>(cfg.type,
+                        detail::relaxation_create<Backend, Matrix>(
+                            handle, A, cfg.prm, backend_prm));
+            }
+        }
+
+        /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply_pre(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                const params&
+                ) const
+        {
+            detail::process_relaxation<Backend>(cfg.type,
+                    detail::relaxation_apply<Backend, Matrix, VectorRHS, VectorX, VectorTMP>(
+                        handle.get(), A, rhs, x, tmp, true, cfg.npre));
+        }
+
+        /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+        template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+        void apply_post(
+                const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp,
+                const params&
+                ) const
+        {
+            detail::process_relaxation<Backend>(cfg.type,
+                    detail::relaxation_apply<Backend, Matrix, VectorRHS, VectorX, VectorTMP>(
+                        handle.get(), A, rhs, x, tmp, false, cfg.npost));
+        }
+
+        /// Relaxation type used on the level.
+        runtime::relaxation::type type() const {
+            return cfg.type;
+        }
+
+        /// Number of pre-relaxations on the level.
+        unsigned npre() const {
+            return cfg.npre;
+        }
+
+        /// Number of post-relaxations on the level.
+        unsigned npost() const {
+            return cfg.npost;
+        }
+
+        /// Describes the configuration of the level.
+        void print(std::ostream &os) const {
+            os << cfg.type << " (npre = " << cfg.npre << ", npost = " << cfg.npost << ")";
+
+            if (automatic)
+                os << ", auto: " << std::setprecision(3) << rate << " per sweep, "
+                   << std::scientific << std::setprecision(2) << sweep_time << " s/sweep"
+                   << std::fixed;
+
+            std::ostringstream info;
+            detail::process_relaxation<Backend>(cfg.type,
+                    detail::relaxation_print<Backend>(handle.get(), info));
+
+            if (!info.str().empty()) os << "; " << info.str();
+        }
+
+    private:
+        struct config {
+            runtime::relaxation::type type;
+            unsigned npre, npost;
+            boost::property_tree::ptree prm;
+
+            config(const boost::property_tree::ptree &p, const params &def)
+                : type (p.get("type",  def.type)),
+                  npre (p.get("npre",  def.npre)),
+                  npost(p.get("npost", def.npost)),
+                  prm(p)
+            {
+                precondition(type != runtime::relaxation::per_level,
+                        "Nested per_level relaxation is not supported");
+            }
+        };
+
+        config cfg;
+        boost::shared_ptr<void> handle;
+
+        bool   automatic;
+        double rate, sweep_time;
+
+        template <class Matrix>
+        void select(
+                const Matrix &A, const params &prm,
+                const boost::property_tree::ptree &candidates,
+                const typename Backend::params &backend_prm
+                )
+        {
+            typedef typename backend::builtin<value_type>::matrix build_matrix;
+            typedef typename Backend::matrix matrix;
+            typedef detail::relaxation_apply<Backend, matrix, vector, vector, vector> apply_type;
+
+            const ptrdiff_t n = backend::rows(A);
+            const unsigned  trials = std::max(1u, prm.trials);
+
+            boost::shared_ptr<matrix> Ab = Backend::copy_matrix(
+                    boost::make_shared<build_matrix>(A), backend_prm);
+
+            // Deterministic pseudo-random initial error.
+            std::vector<value_type> e(n);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                e[i] = static_cast<value_type>((i * 1103515245UL + 12345UL) % 1024) / 1024 - 0.5;
+
+            boost::shared_ptr<vector> f = Backend::create_vector(n, backend_prm);
+            boost::shared_ptr<vector> t = Backend::create_vector(n, backend_prm);
+            backend::clear(*f);
+
+            double best = std::numeric_limits<double>::max();
+
+            BOOST_FOREACH(const boost::property_tree::ptree::value_type &v, candidates) {
+                config c(v.second, prm);
+                boost::shared_ptr<void> h;
+
+                try {
+                    detail::process_relaxation<Backend>(c.type,
+                            detail::relaxation_create<Backend, Matrix>(
+                                h, A, c.prm, backend_prm));
+                } catch(const std::logic_error&) {
+                    // Not supported by the backend.
+                    continue;
+                }
+
+                boost::shared_ptr<vector> x = Backend::copy_vector(e, backend_prm);
+
+                backend::residual(*f, *Ab, *x, *t);
+                double r0 = sqrt(backend::inner_product(*t, *t));
+
+                double tic = amgcl::clock::now();
+                detail::process_relaxation<Backend>(c.type,
+                        apply_type(h.get(), *Ab, *f, *x, *t, true, trials));
+                double time = amgcl::seconds(tic, amgcl::clock::now()) / trials;
+
+                backend::residual(*f, *Ab, *x, *t);
+                double r1 = sqrt(backend::inner_product(*t, *t));
+
+                double q = std::pow(r1 / r0, 1.0 / trials);
+                double score = q < 1 ? time / -std::log(q) : std::numeric_limits<double>::max();
+
+                if (!handle || score < best) {
+                    best       = score;
+                    cfg        = c;
+                    handle     = h;
+                    rate       = q;
+                    sweep_time = time;
+                }
+            }
+
+            precondition(handle, "No suitable relaxation candidates");
+            automatic = true;
+        }
+};
+
+/// Reports the relaxation chosen for the level.
+template <class Backend>
+void print_info(std::ostream &os, const per_level_relaxation<Backend> &r) {
+    r.print(os);
+}
+
+} // namespace runtime
+
+namespace relaxation {
+
+template <class Backend>
+struct level_factory< runtime::per_level_relaxation<Backend> > {
+    template <class Matrix, class Params, class BackendParams>
+    static runtime::per_level_relaxation<Backend>* create(
+            const Matrix &A, const Params &prm,
+            const BackendParams &backend_prm, unsigned level)
+    {
+        return new runtime::per_level_relaxation<Backend>(A, prm, backend_prm, level);
+    }
+};
+
+} // namespace relaxation
+
+namespace runtime {
+
+namespace detail {
+
 //---------------------------------------------------------------------------
 template <
     class Backend,
@@ -313,6 +828,55 @@ inline void process_amg(
                 amgcl::relaxation::chebyshev
                 >(func);
             break;
+        case runtime::relaxation::parallel_ilu0:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::parallel_ilu0
+                >(func);
+            break;
+        case runtime::relaxation::iluk:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::iluk
+                >(func);
+            break;
+        case runtime::relaxation::ilut:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::ilut
+                >(func);
+            break;
+        case runtime::relaxation::hybrid_gauss_seidel:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::hybrid_gauss_seidel
+                >(func);
+            break;
+        case runtime::relaxation::l1_jacobi:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::l1_jacobi
+                >(func);
+            break;
+        case runtime::relaxation::spai_threshold:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::relaxation::spai_threshold
+                >(func);
+            break;
+        case runtime::relaxation::per_level:
+            process_amg<
+                Backend,
+                Coarsening,
+                amgcl::runtime::per_level_relaxation
+                >(func);
+            break;
     }
 }
 
@@ -358,6 +922,14 @@ inline void process_amg(
                     >
                 >(relaxation, func);
             break;
+        case runtime::coarsening::pairwise_aggregation:
+            process_amg<
+                Backend,
+                amgcl::coarsening::aggregation<
+                    amgcl::coarsening::pairwise_aggregates
+                    >
+                >(relaxation, func);
+            break;
     }
 }
 
@@ -728,6 +1300,9 @@ class make_solver : boost::noncopyable {
         typedef typename Backend::value_type value_type;
         typedef boost::property_tree::ptree params;
 
+        typedef amgcl::detail::decoupled_rows<Backend>    Decoupled;
+        typedef amgcl::detail::symmetric_scaling<Backend> Scaling;
+
         /// Constructs the AMG hierarchy and creates iterative solver.
         /**
          * \param coarsening Coarsening kind.
@@ -745,6 +1320,12 @@ class make_solver : boost::noncopyable {
          \endcode
          * Any parameters that are not relevant to the current AMG or Solver
          * classes, are silently ignored.
+         *
+         * The decoupled (e.g. Dirichlet) rows of the system are eliminated
+         * before the hierarchy setup when "eliminate.enable" is set (see
+         * amgcl::detail::decoupled_rows). The hierarchy is built for the
+         * symmetrically scaled system when "scaling.type" is set to "jacobi"
+         * or "ruiz" (see amgcl::detail::symmetric_scaling).
          */
         template <class Matrix>
         make_solver(
@@ -754,17 +1335,30 @@ class make_solver : boost::noncopyable {
                 const Matrix &A,
                 const params &prm = params()
                 )
-            : P(coarsening, relaxation, A,
-                    prm.get_child("amg", amgcl::detail::empty_ptree())
-               ),
+            : n(amgcl::backend::rows(A)),
+              eprm(prm.get_child("eliminate", amgcl::detail::empty_ptree())),
+              sprm(prm.get_child("scaling", amgcl::detail::empty_ptree())),
+              bprm(prm.get_child("amg.backend", amgcl::detail::empty_ptree())),
               solver(solver),
               handle(0)
         {
+            const params &aprm = prm.get_child("amg", amgcl::detail::empty_ptree());
+
+            if (eprm.enable) {
+                E = boost::make_shared<Decoupled>(A, eprm, bprm);
+                if (!E->active()) E.reset();
+            }
+
+            if (E) {
+                setup(coarsening, relaxation, E->system_matrix(), aprm);
+                E->release();
+            } else {
+                setup(coarsening, relaxation, A, aprm);
+            }
+
             runtime::detail::process_solver<Backend>(
                     solver,
-                    runtime::detail::solver_create(
-                        handle, prm, amgcl::backend::rows(A)
-                        )
+                    runtime::detail::solver_create(handle, prm, P->size())
                     );
         }
 
@@ -778,7 +1372,9 @@ class make_solver : boost::noncopyable {
 
         /// Fills the property tree with the actual parameters used.
         void get_params(boost::property_tree::ptree &p) const {
-            P.get_params(p);
+            P->get_params(p);
+            eprm.get(p, "eliminate.");
+            sprm.get(p, "scaling.");
             runtime::detail::process_solver<Backend>(
                     solver,
                     runtime::detail::solver_get_params(handle, p)
@@ -797,6 +1393,11 @@ class make_solver : boost::noncopyable {
          * a strong chance that AMG built for one time step will act as a
          * reasonably good preconditioner for several subsequent time steps
          * \cite Demidov2012.
+         *
+         * When the decoupled rows are eliminated, the same rows should be
+         * decoupled in the new matrix. The elimination and the scaling are
+         * applied to the new matrix as backend operations, so the matrix is
+         * never copied or converted.
          */
         template <class Matrix, class Vec1, class Vec2>
         boost::tuple<size_t, value_type> operator()(
@@ -805,16 +1406,14 @@ class make_solver : boost::noncopyable {
                 Vec2          &x
                 ) const
         {
-            size_t     iters = 0;
-            value_type resid = 0;
+            if (!E) return solve_scaled(A, rhs, x);
 
-            runtime::detail::process_solver<Backend>(
-                    solver,
-                    runtime::detail::solver_solve<Backend, Matrix, Vec1, Vec2>(
-                        handle, P, A, rhs, x, iters, resid)
-                    );
+            E->reduce(A, rhs, x);
+            boost::tuple<size_t, value_type> cnv = solve_scaled(
+                    E->reduced(A), E->rhs(), E->x());
+            E->expand(rhs, x);
 
-            return boost::make_tuple(iters, resid);
+            return cnv;
         }
 
         /// Solves the linear system for the given right-hand side.
@@ -828,7 +1427,13 @@ class make_solver : boost::noncopyable {
                 Vec2          &x
                 ) const
         {
-            return (*this)(P.top_matrix(), rhs, x);
+            if (!E) return solve_scaled(rhs, x);
+
+            E->reduce(rhs, x);
+            boost::tuple<size_t, value_type> cnv = solve_scaled(E->rhs(), E->x());
+            E->expand(rhs, x);
+
+            return cnv;
         }
 
         /// Acts as a preconditioner.
@@ -844,17 +1449,92 @@ class make_solver : boost::noncopyable {
 
         /// Reference to the constructed AMG hierarchy.
         const runtime::amg<Backend>& amg() const {
-            return P;
+            return *P;
         }
 
         /// Returns problem size at the finest level.
         size_t size() const {
-            return P.size();
+            return n;
         }
     private:
-        runtime::amg<Backend>        P;
+        size_t n;
+
+        typename Decoupled::params   eprm;
+        typename Scaling::params     sprm;
+        typename Backend::params     bprm;
+
+        boost::shared_ptr<Decoupled>             E;
+        boost::shared_ptr<Scaling>               Q;
+        boost::shared_ptr< runtime::amg<Backend> > P;
+
         const runtime::solver::type  solver;
         void                        *handle;
+
+        template <class Matrix>
+        void setup(
+                runtime::coarsening::type coarsening,
+                runtime::relaxation::type relaxation,
+                const Matrix &A, const params &prm
+                )
+        {
+            if (sprm.type == amgcl::detail::scaling::none) {
+                P = boost::make_shared< runtime::amg<Backend> >(
+                        coarsening, relaxation, A, prm);
+            } else {
+                Q = boost::make_shared<Scaling>(A, sprm, bprm);
+                P = boost::make_shared< runtime::amg<Backend> >(
+                        coarsening, relaxation, *Q->scaled_matrix(A), prm);
+            }
+        }
+
+        // Solves the system with the matrix of the hierarchy.
+        template <class Vec1, class Vec2>
+        boost::tuple<size_t, value_type> solve_scaled(
+                Vec1 const &rhs, Vec2 &x) const
+        {
+            if (!Q) return solve(P->top_matrix(), rhs, x);
+
+            Q->scale(rhs, x);
+            boost::tuple<size_t, value_type> cnv = solve(
+                    P->top_matrix(), Q->rhs(), Q->x());
+            Q->unscale(x);
+
+            return cnv;
+        }
+
+        // Solves the system with the given matrix.
+        template <class Matrix, class Vec1, class Vec2>
+        boost::tuple<size_t, value_type> solve_scaled(
+                Matrix const &A, Vec1 const &rhs, Vec2 &x) const
+        {
+            if (!Q) return solve(A, rhs, x);
+
+            Q->scale(rhs, x);
+            boost::tuple<size_t, value_type> cnv = solve(
+                    Q->scaled(A), Q->rhs(), Q->x());
+            Q->unscale(x);
+
+            return cnv;
+        }
+
+        template <class Matrix, class Vec1, class Vec2>
+        boost::tuple<size_t, value_type> solve(
+                Matrix  const &A,
+                Vec1    const &rhs,
+                Vec2          &x
+                ) const
+        {
+            size_t     iters = 0;
+            value_type resid = 0;
+
+            runtime::detail::process_solver<Backend>(
+                    solver,
+                    runtime::detail::solver_solve<Backend, Matrix, Vec1, Vec2>(
+                        handle, *P, A, rhs, x, iters, resid)
+                    );
+
+            return boost::make_tuple(iters, resid);
+        }
 };
 
 } // namespace runtime
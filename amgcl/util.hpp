@@ -88,6 +88,21 @@ T eps(size_t n) {
     return 2 * std::numeric_limits<T>::epsilon() * n;
 }
 
+// Pseudo-random weight of a vertex for parallel graph algorithms (coloring,
+// independent sets). The weight only depends on the vertex number, so that
+// the results are reproducible and do not depend on the number of threads.
+inline unsigned random_weight(ptrdiff_t i) {
+    unsigned h = static_cast<unsigned>(i);
+
+    h = (h ^ 61) ^ (h >> 16);
+    h = h + (h << 3);
+    h = h ^ (h >> 4);
+    h = h * 0x27d4eb2d;
+    h = h ^ (h >> 15);
+
+    return h;
+}
+
 } // namespace detail
 
 /// Throws \p message if \p condition is not true.
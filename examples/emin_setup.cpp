@@ -0,0 +1,102 @@
+#include <iostream>
+
+#include <boost/program_options.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/coarsening/plain_aggregates.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/coarsening/smoothed_aggr_emin.hpp>
+#include <amgcl/profiler.hpp>
+
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+template <class Coarsening, class Matrix>
+void setup(const Matrix &A, int t, const std::string &name) {
+    using amgcl::prof;
+
+    typedef boost::shared_ptr<Matrix> matrix_ptr;
+
+    for(int i = 0; i < t; ++i) {
+        typename Coarsening::params prm;
+
+        matrix_ptr P, R;
+
+        prof.tic(name);
+        boost::tie(P, R) = Coarsening::transfer_operators(A, prm);
+        matrix_ptr Ac = Coarsening::coarse_operator(A, *P, *R, prm);
+        prof.toc(name);
+
+        if (i == 0)
+            std::cout << name << ": "
+                      << amgcl::backend::rows(*Ac) << " coarse unknowns, "
+                      << amgcl::backend::nonzeros(*P) << " nonzeros in P, "
+                      << amgcl::backend::nonzeros(*Ac) << " nonzeros in Ac"
+                      << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    using amgcl::prof;
+
+    int m = 64;
+    int t = 3;
+
+    namespace po = boost::program_options;
+    po::options_description desc(
+            "Compares setup time of smoothed_aggregation and smoothed_aggr_emin");
+
+    desc.add_options()
+        ("help,h", "show help")
+        (
+         "size,n",
+         po::value<int>(&m)->default_value(m),
+         "domain size"
+        )
+        (
+         "times,t",
+         po::value<int>(&t)->default_value(t),
+         "number of setup repetitions"
+        )
+        ;
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    typedef amgcl::backend::builtin<double>::matrix Matrix;
+    typedef amgcl::coarsening::plain_aggregates     Aggregates;
+
+    prof.tic("assemble");
+    std::vector<int>    ptr;
+    std::vector<int>    col;
+    std::vector<double> val;
+    std::vector<double> rhs;
+
+    int n = sample_problem(m, val, col, ptr, rhs);
+
+    Matrix A(boost::tie(n, ptr, col, val));
+    prof.toc("assemble");
+
+    std::cout << "Unknowns: " << n << std::endl
+              << "Nonzeros: " << amgcl::backend::nonzeros(A) << std::endl;
+
+    setup< amgcl::coarsening::smoothed_aggregation<Aggregates> >(
+            A, t, "smoothed_aggregation");
+
+    setup< amgcl::coarsening::smoothed_aggr_emin<Aggregates> >(
+            A, t, "smoothed_aggr_emin");
+
+    std::cout << prof << std::endl;
+}
@@ -106,7 +106,8 @@ int main(int argc, char *argv[]) {
         (
          "coarsening,c",
          po::value<amgcl::runtime::coarsening::type>(&coarsening)->default_value(coarsening),
-         "ruge_stuben, aggregation, smoothed_aggregation, smoothed_aggr_emin"
+         "ruge_stuben, aggregation, smoothed_aggregation, smoothed_aggr_emin, "
+         "pairwise_aggregation"
         )
         (
          "relaxation,r",
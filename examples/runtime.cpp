@@ -39,12 +39,13 @@ int main(int argc, char *argv[]) {
         (
          "coarsening,c",
          po::value<amgcl::runtime::coarsening::type>(&coarsening)->default_value(coarsening),
-         "ruge_stuben, aggregation, smoothed_aggregation, smoothed_aggr_emin"
+         "ruge_stuben, aggregation, smoothed_aggregation, smoothed_aggr_emin, "
+         "pairwise_aggregation"
         )
         (
          "relaxation,r",
          po::value<amgcl::runtime::relaxation::type>(&relaxation)->default_value(relaxation),
-         "gauss_seidel, multicolor_gauss_seidel, ilu0, damped_jacobi, spai0, chebyshev"
+         "gauss_seidel, multicolor_gauss_seidel, ilu0, damped_jacobi, spai0, chebyshev, parallel_ilu0, iluk, ilut, hybrid_gauss_seidel, l1_jacobi, spai_threshold, per_level"
         )
         (
          "solver,s",
@@ -12,6 +12,7 @@
 #include <amgcl/runtime.hpp>
 #include <amgcl/backend/eigen.hpp>
 #include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/coarsening/rigid_body_modes.hpp>
 #include <amgcl/profiler.hpp>
 
 typedef Eigen::SparseMatrix<double, Eigen::RowMajor, int> EigenMatrix;
@@ -73,6 +74,7 @@ int main(int argc, char *argv[]) {
     std::string A_file;
     std::string rhs_file;
     std::string null_file;
+    std::string coord_file;
     std::string out_file = "out.mtx";
 
     namespace po = boost::program_options;
@@ -83,7 +85,8 @@ int main(int argc, char *argv[]) {
         (
          "coarsening,c",
          po::value<amgcl::runtime::coarsening::type>(&coarsening)->default_value(coarsening),
-         "ruge_stuben, aggregation, smoothed_aggregation, smoothed_aggr_emin"
+         "ruge_stuben, aggregation, smoothed_aggregation, smoothed_aggr_emin, "
+         "pairwise_aggregation"
         )
         (
          "relaxation,r",
@@ -115,6 +118,12 @@ int main(int argc, char *argv[]) {
          po::value<std::string>(&null_file),
          "Zero energy mode vectors in MatrixMarket format"
         )
+        (
+         "coords,C",
+         po::value<std::string>(&coord_file),
+         "Node coordinates in MatrixMarket format. When given, rigid body "
+         "modes are used as zero energy mode vectors"
+        )
         (
          "output,o",
          po::value<std::string>(&out_file),
@@ -167,6 +176,24 @@ int main(int argc, char *argv[]) {
         prm.put("amg.coarsening.nullspace.B",    Z.data());
     }
 
+    std::vector<double> rbm;
+    if (vm.count("coords")) {
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> C;
+        mmread(C, coord_file);
+
+        precondition(
+                C.rows() * C.cols() == A.rows(),
+                "Inconsistent dimensions in coordinates file"
+                );
+
+        int cols = amgcl::coarsening::rigid_body_modes(C.cols(),
+                boost::make_iterator_range(C.data(), C.data() + C.size()), rbm);
+
+        prm.put("amg.coarsening.nullspace.cols", cols);
+        prm.put("amg.coarsening.nullspace.rows", A.rows());
+        prm.put("amg.coarsening.nullspace.B",    &rbm[0]);
+    }
+
     precondition(A.rows() == rhs.size(), "Matrix and RHS sizes differ");
     prof.toc("read");
 
@@ -0,0 +1,77 @@
+#include <iostream>
+
+#include <boost/program_options.hpp>
+#include <boost/make_shared.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/relaxation/spai1.hpp>
+#include <amgcl/profiler.hpp>
+
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+int main(int argc, char *argv[]) {
+    using amgcl::prof;
+
+    int m = 64;
+    int t = 3;
+
+    namespace po = boost::program_options;
+    po::options_description desc("Measures setup time of the SPAI-1 smoother");
+
+    desc.add_options()
+        ("help,h", "show help")
+        (
+         "size,n",
+         po::value<int>(&m)->default_value(m),
+         "domain size"
+        )
+        (
+         "times,t",
+         po::value<int>(&t)->default_value(t),
+         "number of setup repetitions"
+        )
+        ;
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef Backend::matrix                 Matrix;
+    typedef amgcl::relaxation::spai1<Backend> Relax;
+
+    prof.tic("assemble");
+    std::vector<int>    ptr;
+    std::vector<int>    col;
+    std::vector<double> val;
+    std::vector<double> rhs;
+
+    int n = sample_problem(m, val, col, ptr, rhs);
+
+    Matrix A(boost::tie(n, ptr, col, val));
+    prof.toc("assemble");
+
+    std::cout << "Unknowns: " << n << std::endl
+              << "Nonzeros: " << amgcl::backend::nonzeros(A) << std::endl;
+
+    Relax::params   prm;
+    Backend::params bprm;
+
+    for(int i = 0; i < t; ++i) {
+        prof.tic("setup");
+        Relax relax(A, prm, bprm);
+        prof.toc("setup");
+    }
+
+    std::cout << prof << std::endl;
+}
@@ -6,8 +6,10 @@
 #include <amgcl/runtime.hpp>
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/coarsening/rigid_body_modes.hpp>
 
 #include "amgcl.h"
+#include "amgcl_params.hpp"
 
 #ifdef AMGCL_PROFILING
 #include <amgcl/profiler.hpp>
@@ -22,6 +24,7 @@ ASSERT_EQUAL(amgclCoarseningRugeStuben,          amgcl::runtime::coarsening::rug
 ASSERT_EQUAL(amgclCoarseningAggregation,         amgcl::runtime::coarsening::aggregation);
 ASSERT_EQUAL(amgclCoarseningSmoothedAggregation, amgcl::runtime::coarsening::smoothed_aggregation);
 ASSERT_EQUAL(amgclCoarseningSmoothedAggrEMin,    amgcl::runtime::coarsening::smoothed_aggr_emin);
+ASSERT_EQUAL(amgclCoarseningPairwiseAggregation, amgcl::runtime::coarsening::pairwise_aggregation);
 
 ASSERT_EQUAL(amgclRelaxationGaussSeidel,         amgcl::runtime::relaxation::gauss_seidel);
 ASSERT_EQUAL(amgclRelaxationMCGaussSeidel,       amgcl::runtime::relaxation::multicolor_gauss_seidel);
@@ -30,6 +33,13 @@ ASSERT_EQUAL(amgclRelaxationDampedJacobi,        amgcl::runtime::relaxation::dam
 ASSERT_EQUAL(amgclRelaxationSPAI0,               amgcl::runtime::relaxation::spai0);
 ASSERT_EQUAL(amgclRelaxationSPAI1,               amgcl::runtime::relaxation::spai1);
 ASSERT_EQUAL(amgclRelaxationChebyshev,           amgcl::runtime::relaxation::chebyshev);
+ASSERT_EQUAL(amgclRelaxationParallelILU0,        amgcl::runtime::relaxation::parallel_ilu0);
+ASSERT_EQUAL(amgclRelaxationILUK,                amgcl::runtime::relaxation::iluk);
+ASSERT_EQUAL(amgclRelaxationILUT,                amgcl::runtime::relaxation::ilut);
+ASSERT_EQUAL(amgclRelaxationHybridGaussSeidel,   amgcl::runtime::relaxation::hybrid_gauss_seidel);
+ASSERT_EQUAL(amgclRelaxationL1Jacobi,            amgcl::runtime::relaxation::l1_jacobi);
+ASSERT_EQUAL(amgclRelaxationSPAIThreshold,       amgcl::runtime::relaxation::spai_threshold);
+ASSERT_EQUAL(amgclRelaxationPerLevel,            amgcl::runtime::relaxation::per_level);
 
 ASSERT_EQUAL(amgclSolverCG,                      amgcl::runtime::solver::cg);
 ASSERT_EQUAL(amgclSolverBiCGStab,                amgcl::runtime::solver::bicgstab);
@@ -40,7 +50,6 @@ ASSERT_EQUAL(amgclSolverGMRES,                   amgcl::runtime::solver::gmres);
 typedef amgcl::backend::builtin<double>      Backend;
 typedef amgcl::runtime::amg<Backend>         AMG;
 typedef amgcl::runtime::make_solver<Backend> Solver;
-typedef boost::property_tree::ptree          Params;
 
 //---------------------------------------------------------------------------
 amgclHandle STDCALL amgcl_params_create() {
@@ -57,6 +66,17 @@ void STDCALL amgcl_params_setf(amgclHandle prm, const char *name, float value) {
     static_cast<Params*>(prm)->put(name, value);
 }
 
+//---------------------------------------------------------------------------
+void STDCALL amgcl_params_set_rigid_body_modes(
+        amgclHandle prm, int ndim, int n_nodes, const double *coo)
+{
+    Params *p = static_cast<Params*>(prm);
+
+    p->nullspace_cols = amgcl::coarsening::rigid_body_modes(ndim,
+            boost::make_iterator_range(coo, coo + n_nodes * ndim),
+            p->nullspace);
+}
+
 //---------------------------------------------------------------------------
 void STDCALL amgcl_params_destroy(amgclHandle prm) {
     delete static_cast<Params*>(prm);
@@ -83,7 +103,7 @@ amgclHandle STDCALL amgcl_precond_create(
                     boost::make_iterator_range(col, col + ptr[n]),
                     boost::make_iterator_range(val, val + ptr[n])
                     ),
-                *static_cast<Params*>(prm)
+                static_cast<Params*>(prm)->with_nullspace("")
                 )
             );
 }
@@ -129,7 +149,7 @@ amgclHandle STDCALL amgcl_solver_create(
                     boost::make_iterator_range(col, col + ptr[n]),
                     boost::make_iterator_range(val, val + ptr[n])
                     ),
-                *static_cast<Params*>(prm)
+                static_cast<Params*>(prm)->with_nullspace("amg.")
                 )
             );
 }
@@ -46,7 +46,8 @@ typedef enum {
     amgclCoarseningRugeStuben,
     amgclCoarseningAggregation,
     amgclCoarseningSmoothedAggregation,
-    amgclCoarseningSmoothedAggrEMin
+    amgclCoarseningSmoothedAggrEMin,
+    amgclCoarseningPairwiseAggregation
 } amgclCoarsening;
 
 // Relaxation
@@ -57,7 +58,14 @@ typedef enum {
     amgclRelaxationDampedJacobi,
     amgclRelaxationSPAI0,
     amgclRelaxationSPAI1,
-    amgclRelaxationChebyshev
+    amgclRelaxationChebyshev,
+    amgclRelaxationParallelILU0,
+    amgclRelaxationILUK,
+    amgclRelaxationILUT,
+    amgclRelaxationHybridGaussSeidel,
+    amgclRelaxationL1Jacobi,
+    amgclRelaxationSPAIThreshold,
+    amgclRelaxationPerLevel
 } amgclRelaxation;
 
 // Solver
@@ -79,6 +87,15 @@ void STDCALL amgcl_params_seti(amgclHandle prm, const char *name, int   value);
 // Set floating point parameter in a parameter list.
 void STDCALL amgcl_params_setf(amgclHandle prm, const char *name, float value);
 
+// Set rigid body modes computed from the node coordinates as the near
+// nullspace for aggregation-based coarsening. coo contains ndim (2 or 3)
+// coordinates per node; the unknowns are assumed to be interleaved, with
+// ndim unknowns per node. The modes should be used with the default
+// aggregation block size of 1. With amgcl_mpi_create(), coo contains the
+// coordinates of the local nodes, and the modes are used by the local AMG.
+void STDCALL amgcl_params_set_rigid_body_modes(
+        amgclHandle prm, int ndim, int n_nodes, const double *coo);
+
 // Destroy parameter list.
 void STDCALL amgcl_params_destroy(amgclHandle prm);
 
@@ -9,6 +9,7 @@
 #include <amgcl/adapter/crs_tuple.hpp>
 
 #include "amgcl_mpi.h"
+#include "amgcl_params.hpp"
 
 #define ASSERT_EQUAL(e1, e2) BOOST_STATIC_ASSERT((int)(e1) == (int)(e2))
 
@@ -20,7 +21,6 @@ ASSERT_EQUAL(amgclDirectSolverPastix,    amgcl::runtime::direct_solver::pastix);
 //---------------------------------------------------------------------------
 typedef amgcl::backend::builtin<double>                   Backend;
 typedef amgcl::runtime::mpi::subdomain_deflation<Backend> Solver;
-typedef boost::property_tree::ptree                       Params;
 
 //---------------------------------------------------------------------------
 struct deflation_vectors {
@@ -70,7 +70,7 @@ amgclHandle STDCALL amgcl_mpi_create(
                     boost::make_iterator_range(val, val + ptr[n])
                     ),
                 deflation_vectors(n_def_vec, def_vec_func, def_vec_data),
-                *static_cast<Params*>(params)
+                static_cast<Params*>(params)->with_nullspace("amg.")
                 )
             );
 }
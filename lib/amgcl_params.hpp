@@ -0,0 +1,62 @@
+#ifndef LIB_AMGCL_PARAMS_HPP
+#define LIB_AMGCL_PARAMS_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2015 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   lib/amgcl_params.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Parameter list behind the amgclHandle of amgcl_params_create().
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+struct Params : boost::property_tree::ptree {
+    // Near nullspace vectors (rigid body modes).
+    int                 nullspace_cols;
+    std::vector<double> nullspace;
+
+    Params() : nullspace_cols(0) {}
+
+    // Returns the parameters with the near nullspace vectors attached under
+    // the given prefix.
+    boost::property_tree::ptree with_nullspace(const std::string &prefix) const {
+        boost::property_tree::ptree p = *this;
+
+        if (nullspace_cols > 0) {
+            p.put(prefix + "coarsening.nullspace.cols", nullspace_cols);
+            p.put(prefix + "coarsening.nullspace.rows",
+                    nullspace.size() / nullspace_cols);
+            p.put(prefix + "coarsening.nullspace.B", &nullspace[0]);
+        }
+
+        return p;
+    }
+};
+
+#endif
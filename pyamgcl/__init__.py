@@ -3,6 +3,19 @@ import pyamgcl_ext
 from pyamgcl_ext import coarsening, relaxation, solver_type
 from scipy.sparse.linalg import LinearOperator
 
+def _coordinates(coo):
+    """
+    Converts node coordinates to the arguments expected by pyamgcl_ext.
+
+    Returns the number of spatial dimensions and the flattened coordinate
+    array. Empty array is returned when the coordinates are not given.
+    """
+    if coo is None:
+        return 0, numpy.zeros(0)
+
+    coo = numpy.ascontiguousarray(coo, dtype=numpy.float64)
+    return coo.shape[1], coo.reshape(-1)
+
 class make_solver:
     """
     Iterative solver preconditioned by algebraic multigrid
@@ -16,7 +29,8 @@ class make_solver:
             coarsening=pyamgcl_ext.coarsening.smoothed_aggregation,
             relaxation=pyamgcl_ext.relaxation.spai0,
             solver=pyamgcl_ext.solver_type.bicgstabl,
-            prm={}
+            prm={},
+            coo=None
             ):
         """
         Class constructor.
@@ -26,7 +40,8 @@ class make_solver:
         Parameters
         ----------
         A : the system matrix in scipy.sparse format
-        coarsening : {ruge_stuben, aggregation, *smoothed_aggregation*, smoothed_aggr_emin}
+        coarsening : {ruge_stuben, aggregation, *smoothed_aggregation*,
+                      smoothed_aggr_emin, pairwise_aggregation}
             The coarsening type to use for construction of the multigrid
             hierarchy.
         relaxation : {damped_jacobi, gauss_seidel, chebyshev, *spai0*, ilu0}
@@ -34,14 +49,21 @@ class make_solver:
         solver : {cg, bicgstab, *bicgstabl*, gmres}
             The iterative solver to use.
         prm : dictionary with amgcl parameters
+        coo : node coordinates (optional), an array of shape (n_nodes, ndim)
+            with ndim = 2 or 3. When given, rigid body modes computed from
+            the coordinates are used as the near nullspace for
+            aggregation-based coarsening. The unknowns are assumed to be
+            interleaved, with ndim unknowns per node.
         """
         Acsr = A.tocsr()
+        ndim, coo = _coordinates(coo)
 
         self.S = pyamgcl_ext.make_solver(
                 coarsening, relaxation, solver, prm,
                 Acsr.indptr.astype(numpy.int32),
                 Acsr.indices.astype(numpy.int32),
-                Acsr.data.astype(numpy.float64)
+                Acsr.data.astype(numpy.float64),
+                ndim, coo
                 )
 
     def __repr__(self):
@@ -106,7 +128,8 @@ class make_preconditioner(LinearOperator):
             A,
             coarsening=pyamgcl_ext.coarsening.smoothed_aggregation,
             relaxation=pyamgcl_ext.relaxation.spai0,
-            prm={}
+            prm={},
+            coo=None
             ):
         """
         Class constructor.
@@ -116,20 +139,28 @@ class make_preconditioner(LinearOperator):
         Parameters
         ----------
         A : the system matrix in scipy.sparse format
-        coarsening : {ruge_stuben, aggregation, *smoothed_aggregation*, smoothed_aggr_emin}
+        coarsening : {ruge_stuben, aggregation, *smoothed_aggregation*,
+                      smoothed_aggr_emin, pairwise_aggregation}
             The coarsening type to use for construction of the multigrid
             hierarchy.
         relaxation : {damped_jacobi, gauss_seidel, chebyshev, *spai0*, ilu0}
             The relaxation scheme to use for multigrid cycles.
         prm : dictionary with amgcl parameters
+        coo : node coordinates (optional), an array of shape (n_nodes, ndim)
+            with ndim = 2 or 3. When given, rigid body modes computed from
+            the coordinates are used as the near nullspace for
+            aggregation-based coarsening. The unknowns are assumed to be
+            interleaved, with ndim unknowns per node.
         """
         Acsr = A.tocsr()
+        ndim, coo = _coordinates(coo)
 
         self.P = pyamgcl_ext.make_preconditioner(
                 coarsening, relaxation, prm,
                 Acsr.indptr.astype(numpy.int32),
                 Acsr.indices.astype(numpy.int32),
-                Acsr.data.astype(numpy.float64)
+                Acsr.data.astype(numpy.float64),
+                ndim, coo
                 )
 
         LinearOperator.__init__(self, A.shape, self.P)
@@ -19,6 +19,7 @@
 
 #include <amgcl/runtime.hpp>
 #include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/coarsening/rigid_body_modes.hpp>
 
 namespace amgcl {
 #ifdef AMGCL_PROFILING
@@ -48,6 +49,28 @@ boost::property_tree::ptree make_ptree(const boost::python::dict &args) {
     return p;
 }
 
+//---------------------------------------------------------------------------
+// Attaches rigid body modes computed from the node coordinates as the near
+// nullspace. B holds the modes and should outlive the AMG construction.
+boost::property_tree::ptree make_ptree(
+        const boost::python::dict &args,
+        int ndim, const numpy_boost<double, 1> &coo,
+        std::vector<double> &B, const std::string &prefix
+        )
+{
+    boost::property_tree::ptree p = make_ptree(args);
+
+    if (ndim > 0 && coo.num_elements() > 0) {
+        int cols = amgcl::coarsening::rigid_body_modes(ndim, coo, B);
+
+        p.put(prefix + "coarsening.nullspace.cols", cols);
+        p.put(prefix + "coarsening.nullspace.rows", B.size() / cols);
+        p.put(prefix + "coarsening.nullspace.B",    &B[0]);
+    }
+
+    return p;
+}
+
 //---------------------------------------------------------------------------
 struct make_solver {
     make_solver(
@@ -57,10 +80,13 @@ struct make_solver {
             const boost::python::dict    &prm,
             const numpy_boost<int,    1> &ptr,
             const numpy_boost<int,    1> &col,
-            const numpy_boost<double, 1> &val
+            const numpy_boost<double, 1> &val,
+            int                           ndim,
+            const numpy_boost<double, 1> &coo
           )
         : n(ptr.num_elements() - 1),
-          S(coarsening, relaxation, solver, boost::tie(n, ptr, col, val), make_ptree(prm))
+          S(coarsening, relaxation, solver, boost::tie(n, ptr, col, val),
+            make_ptree(prm, ndim, coo, B, "amg."))
     { }
 
     PyObject* solve(const numpy_boost<double, 1> &rhs) const {
@@ -107,6 +133,7 @@ struct make_solver {
 
     private:
         int n;
+        std::vector<double> B;
         amgcl::runtime::make_solver< amgcl::backend::builtin<double> > S;
 
         mutable boost::tuple<int, double> cnv;
@@ -121,10 +148,13 @@ struct make_preconditioner {
             const boost::python::dict    &prm,
             const numpy_boost<int,    1> &ptr,
             const numpy_boost<int,    1> &col,
-            const numpy_boost<double, 1> &val
+            const numpy_boost<double, 1> &val,
+            int                           ndim,
+            const numpy_boost<double, 1> &coo
           )
         : n(ptr.num_elements() - 1),
-          P(coarsening, relaxation, boost::tie(n, ptr, col, val), make_ptree(prm))
+          P(coarsening, relaxation, boost::tie(n, ptr, col, val),
+            make_ptree(prm, ndim, coo, B, ""))
     { }
 
     PyObject* apply(const numpy_boost<double, 1> &rhs) const {
@@ -144,6 +174,7 @@ struct make_preconditioner {
 
     private:
         int n;
+        std::vector<double> B;
         amgcl::runtime::amg< amgcl::backend::builtin<double> > P;
 };
 
@@ -168,6 +199,7 @@ BOOST_PYTHON_MODULE(pyamgcl_ext)
         .value("aggregation",          amgcl::runtime::coarsening::aggregation)
         .value("smoothed_aggregation", amgcl::runtime::coarsening::smoothed_aggregation)
         .value("smoothed_aggr_emin",   amgcl::runtime::coarsening::smoothed_aggr_emin)
+        .value("pairwise_aggregation", amgcl::runtime::coarsening::pairwise_aggregation)
         ;
 
     enum_<amgcl::runtime::relaxation::type>("relaxation", "relaxation schemes")
@@ -177,6 +209,13 @@ BOOST_PYTHON_MODULE(pyamgcl_ext)
         .value("chebyshev",                amgcl::runtime::relaxation::chebyshev)
         .value("spai0",                    amgcl::runtime::relaxation::spai0)
         .value("ilu0",                     amgcl::runtime::relaxation::ilu0)
+        .value("parallel_ilu0",            amgcl::runtime::relaxation::parallel_ilu0)
+        .value("iluk",                     amgcl::runtime::relaxation::iluk)
+        .value("ilut",                     amgcl::runtime::relaxation::ilut)
+        .value("hybrid_gauss_seidel",      amgcl::runtime::relaxation::hybrid_gauss_seidel)
+        .value("l1_jacobi",                amgcl::runtime::relaxation::l1_jacobi)
+        .value("spai_threshold",           amgcl::runtime::relaxation::spai_threshold)
+        .value("per_level",                amgcl::runtime::relaxation::per_level)
         ;
 
     enum_<amgcl::runtime::solver::type>("solver_type", "iterative solvers")
@@ -212,6 +251,8 @@ BOOST_PYTHON_MODULE(pyamgcl_ext)
                 const dict&,
                 const numpy_boost<int,    1>&,
                 const numpy_boost<int,    1>&,
+                const numpy_boost<double, 1>&,
+                int,
                 const numpy_boost<double, 1>&
             >(
                 args(
@@ -221,7 +262,9 @@ BOOST_PYTHON_MODULE(pyamgcl_ext)
                     "params",
                     "indptr",
                     "indices",
-                    "values"
+                    "values",
+                    "ndim",
+                    "coo"
                     ),
                 "Creates iterative solver preconditioned by AMG"
              )
@@ -246,6 +289,8 @@ BOOST_PYTHON_MODULE(pyamgcl_ext)
                 const dict&,
                 const numpy_boost<int,    1>&,
                 const numpy_boost<int,    1>&,
+                const numpy_boost<double, 1>&,
+                int,
                 const numpy_boost<double, 1>&
             >(
                 args(
@@ -254,7 +299,9 @@ BOOST_PYTHON_MODULE(pyamgcl_ext)
                     "params",
                     "indptr",
                     "indices",
-                    "values"
+                    "values",
+                    "ndim",
+                    "coo"
                     ),
                 "Creates AMG hierarchy to be used as a preconditioner"
              )
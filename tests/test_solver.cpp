@@ -4,6 +4,13 @@
 #include <boost/mpl/for_each.hpp>
 
 #include <amgcl/runtime.hpp>
+#include <amgcl/amgcl.hpp>
+#include <amgcl/coarsening/plain_aggregates.hpp>
+#include <amgcl/coarsening/cached_aggregates.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/cg.hpp>
+#include <amgcl/solver/bicgstab.hpp>
 #include <amgcl/adapter/crs_tuple.hpp>
 #include <amgcl/profiler.hpp>
 
@@ -27,7 +34,8 @@ namespace amgcl {
 
 //---------------------------------------------------------------------------
 typedef boost::mpl::list<
-      amgcl::backend::block_crs<double>
+      amgcl::backend::builtin<double>
+    , amgcl::backend::block_crs<double>
 #ifdef AMGCL_HAVE_EIGEN
     , amgcl::backend::eigen<double>
 #endif
@@ -86,6 +94,267 @@ void test_solver(
     BOOST_CHECK_SMALL(resid, 1e-4);
 }
 
+//---------------------------------------------------------------------------
+// Poisson problem where the boundary unknowns are fixed with Dirichlet
+// rows. The Dirichlet rows are not scaled the same way as the interior ones.
+// The boundary columns are kept in the interior rows.
+template <class value_type>
+size_t dirichlet_problem(
+        int n,
+        std::vector<value_type> &val,
+        std::vector<int>        &col,
+        std::vector<int>        &ptr,
+        std::vector<value_type> &rhs
+        )
+{
+    std::vector<value_type> v;
+    std::vector<int>        c;
+    std::vector<int>        p;
+
+    size_t n3 = sample_problem(n, v, c, p, rhs);
+
+    const value_type h2i = static_cast<value_type>((n - 1) * (n - 1));
+
+    ptr.clear(); ptr.push_back(0);
+    col.clear();
+    val.clear();
+
+    for(int k = 0, idx = 0; k < n; ++k) {
+        for(int j = 0; j < n; ++j) {
+            for(int i = 0; i < n; ++i, ++idx) {
+                if (i == 0 || i + 1 == n || j == 0 || j + 1 == n || k == 0 || k + 1 == n) {
+                    col.push_back(idx);
+                    val.push_back(h2i);
+                } else {
+                    for(int e = p[idx]; e < p[idx + 1]; ++e) {
+                        col.push_back(c[e]);
+                        val.push_back(v[e]);
+                    }
+                }
+
+                ptr.push_back(static_cast<int>(col.size()));
+            }
+        }
+    }
+
+    return n3;
+}
+
+//---------------------------------------------------------------------------
+// Poisson problem with the couplings in x direction scaled by (1 + eps) and
+// the others by (1 - eps). The row sums are kept. The couplings in z
+// direction are dropped when drop_z is set.
+size_t perturbed_problem(
+        int n, double eps, bool drop_z,
+        std::vector<double> &val,
+        std::vector<int>    &col,
+        std::vector<int>    &ptr,
+        std::vector<double> &rhs
+        )
+{
+    std::vector<double> v;
+    std::vector<int>    c;
+    std::vector<int>    p;
+
+    size_t n3 = sample_problem(n, v, c, p, rhs);
+
+    ptr.clear(); ptr.push_back(0);
+    col.clear();
+    val.clear();
+
+    for(int i = 0; i < static_cast<int>(n3); ++i) {
+        double d = 0;
+        int    h = -1;
+
+        for(int j = p[i]; j < p[i+1]; ++j) {
+            int dist = std::abs(c[j] - i);
+
+            if (dist == 0) {
+                h = static_cast<int>(col.size());
+                d += v[j];
+            } else {
+                double f = (dist == 1 ? 1 + eps : 1 - eps);
+                d += (1 - f) * v[j];
+
+                if (drop_z && dist == n * n) {
+                    d += f * v[j];
+                    continue;
+                }
+
+                v[j] *= f;
+            }
+
+            col.push_back(c[j]);
+            val.push_back(v[j]);
+        }
+
+        val[h] = d;
+        ptr.push_back(static_cast<int>(col.size()));
+    }
+
+    return n3;
+}
+
+//---------------------------------------------------------------------------
+// Relative residual of the original system.
+template <class Backend, class Matrix, class Vector>
+double true_residual(const Matrix &A, const Vector &rhs, const Vector &x)
+{
+    boost::shared_ptr<Vector> r = Backend::create_vector(
+            amgcl::backend::rows(A), typename Backend::params());
+
+    amgcl::backend::residual(rhs, A, x, *r);
+
+    return sqrt(amgcl::backend::inner_product(*r, *r) /
+                amgcl::backend::inner_product(rhs, rhs));
+}
+
+//---------------------------------------------------------------------------
+// Elimination of the decoupled rows and scaling of the system. The solution
+// is checked against the original system, both for the matrix used for the
+// setup and for the backend matrix passed to the solve.
+template <class Backend>
+void test_preprocessing(bool eliminate, amgcl::detail::scaling::type scaling)
+{
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::vector     vector;
+    typedef typename Backend::matrix     matrix;
+
+    typedef typename amgcl::backend::builtin<value_type>::matrix build_matrix;
+
+    std::vector<int>        ptr;
+    std::vector<int>        col;
+    std::vector<value_type> val;
+    std::vector<value_type> rhs;
+
+    size_t n = dirichlet_problem(16, val, col, ptr, rhs);
+
+    typename Backend::params bprm;
+
+    boost::shared_ptr<matrix> A = Backend::copy_matrix(
+            boost::make_shared<build_matrix>(boost::tie(n, ptr, col, val)),
+            bprm);
+
+    boost::shared_ptr<vector> y = Backend::copy_vector(rhs, bprm);
+    boost::shared_ptr<vector> x = Backend::create_vector(n, bprm);
+
+    // Runtime interface.
+    {
+        boost::property_tree::ptree prm;
+        prm.put("eliminate.enable", eliminate);
+        prm.put("scaling.type",     scaling);
+        prm.put("solver.tol",       1e-8);
+        prm.put("amg.coarse_enough", 500);
+
+        amgcl::runtime::make_solver<Backend> solve(
+                amgcl::runtime::coarsening::smoothed_aggregation,
+                amgcl::runtime::relaxation::spai0,
+                amgcl::runtime::solver::bicgstab,
+                boost::tie(n, ptr, col, val), prm
+                );
+
+        amgcl::backend::clear(*x);
+        solve(*y, *x);
+        BOOST_CHECK_SMALL(true_residual<Backend>(*A, *y, *x), 1e-6);
+
+        amgcl::backend::clear(*x);
+        solve(*A, *y, *x);
+        BOOST_CHECK_SMALL(true_residual<Backend>(*A, *y, *x), 1e-6);
+    }
+
+    // Compile-time interface.
+    {
+        typedef amgcl::make_solver<
+            Backend,
+            amgcl::coarsening::smoothed_aggregation<
+                amgcl::coarsening::plain_aggregates
+                >,
+            amgcl::relaxation::spai0,
+            amgcl::solver::bicgstab
+            > Solver;
+
+        typename Solver::params prm;
+        prm.eliminate.enable = eliminate;
+        prm.scaling.type = scaling;
+        prm.solver.tol = 1e-8;
+        prm.amg.coarse_enough = 500;
+
+        Solver solve(boost::tie(n, ptr, col, val), prm);
+
+        amgcl::backend::clear(*x);
+        solve(*y, *x);
+        BOOST_CHECK_SMALL(true_residual<Backend>(*A, *y, *x), 1e-6);
+
+        amgcl::backend::clear(*x);
+        solve(*A, *y, *x);
+        BOOST_CHECK_SMALL(true_residual<Backend>(*A, *y, *x), 1e-6);
+    }
+}
+
+//---------------------------------------------------------------------------
+// Aggressive coarsening on the first level.
+template <class Backend>
+void test_aggressive(amgcl::runtime::coarsening::type coarsening)
+{
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::vector     vector;
+
+    std::vector<int>        ptr;
+    std::vector<int>        col;
+    std::vector<value_type> val;
+    std::vector<value_type> rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    boost::property_tree::ptree prm;
+    prm.put("amg.coarse_enough", 500);
+    prm.put("amg.coarsening.aggressive_levels", 1);
+
+    amgcl::runtime::make_solver<Backend> solve(
+            coarsening,
+            amgcl::runtime::relaxation::spai0,
+            amgcl::runtime::solver::cg,
+            boost::tie(n, ptr, col, val), prm
+            );
+
+    std::ostringstream info;
+    info << solve.amg();
+    std::cout << info.str() << std::endl;
+
+    // Only the first level should be flagged as aggressive in the hierarchy
+    // description.
+    std::istringstream lines(info.str());
+    std::string line;
+    int  aggressive = 0;
+    bool first      = false;
+
+    while(std::getline(lines, line)) {
+        if (line.find(" aggressive") == std::string::npos) continue;
+
+        ++aggressive;
+        first = line.compare(0, 6, "    0 ") == 0;
+    }
+
+    BOOST_CHECK_EQUAL(aggressive, 1);
+    BOOST_CHECK(first);
+
+    typename Backend::params bprm;
+    boost::shared_ptr<vector> y = Backend::copy_vector(rhs, bprm);
+    boost::shared_ptr<vector> x = Backend::create_vector(n, bprm);
+
+    amgcl::backend::clear(*x);
+
+    size_t iters;
+    double resid;
+    boost::tie(iters, resid) = solve(*y, *x);
+
+    std::cout << "Iterations: " << iters << std::endl
+              << "Error:      " << resid << std::endl
+              << std::endl;
+
+    BOOST_CHECK_SMALL(resid, 1e-6);
+}
+
 //---------------------------------------------------------------------------
 BOOST_AUTO_TEST_SUITE( test_solvers )
 
@@ -95,7 +364,8 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_backends, Backend, backend_list)
         amgcl::runtime::coarsening::ruge_stuben,
         amgcl::runtime::coarsening::aggregation,
         amgcl::runtime::coarsening::smoothed_aggregation,
-        amgcl::runtime::coarsening::smoothed_aggr_emin
+        amgcl::runtime::coarsening::smoothed_aggr_emin,
+        amgcl::runtime::coarsening::pairwise_aggregation
     };
 
     amgcl::runtime::relaxation::type relaxation[] = {
@@ -104,7 +374,14 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_backends, Backend, backend_list)
         amgcl::runtime::relaxation::ilu0,
         amgcl::runtime::relaxation::damped_jacobi,
         amgcl::runtime::relaxation::spai0,
-        amgcl::runtime::relaxation::chebyshev
+        amgcl::runtime::relaxation::chebyshev,
+        amgcl::runtime::relaxation::parallel_ilu0,
+        amgcl::runtime::relaxation::iluk,
+        amgcl::runtime::relaxation::ilut,
+        amgcl::runtime::relaxation::hybrid_gauss_seidel,
+        amgcl::runtime::relaxation::l1_jacobi,
+        amgcl::runtime::relaxation::spai_threshold,
+        amgcl::runtime::relaxation::per_level
     };
 
     amgcl::runtime::solver::type solver[] = {
@@ -130,4 +407,111 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_backends, Backend, backend_list)
 
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_eliminate_and_scale, Backend, backend_list)
+{
+    amgcl::detail::scaling::type scaling[] = {
+        amgcl::detail::scaling::none,
+        amgcl::detail::scaling::jacobi,
+        amgcl::detail::scaling::ruiz
+    };
+
+    for(int eliminate = 0; eliminate < 2; ++eliminate) {
+        BOOST_FOREACH(amgcl::detail::scaling::type s, scaling) {
+            std::cout
+                << Backend::name() << " eliminate=" << eliminate
+                << " scaling=" << s << std::endl;
+
+            test_preprocessing<Backend>(eliminate, s);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_rebuild)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+
+    typedef amgcl::coarsening::cached_aggregates<
+        amgcl::coarsening::plain_aggregates
+        > Aggregates;
+
+    typedef amgcl::make_solver<
+        Backend,
+        amgcl::coarsening::smoothed_aggregation<Aggregates>,
+        amgcl::relaxation::spai0,
+        amgcl::solver::cg
+        > Solver;
+
+    std::vector<int>    ptr;
+    std::vector<int>    col;
+    std::vector<double> val;
+    std::vector<double> rhs;
+
+    size_t n = perturbed_problem(16, 0, false, val, col, ptr, rhs);
+
+    Solver::params prm;
+    prm.amg.coarse_enough = 500;
+    prm.amg.coarsening.aggr.max_iter_growth = 0;
+
+    boost::shared_ptr<Aggregates::cache> store = prm.amg.coarsening.aggr.store;
+
+    Solver solve(boost::tie(n, ptr, col, val), prm);
+
+    std::vector<double> x(n);
+    size_t iters;
+    double resid;
+
+    boost::tie(iters, resid) = solve(rhs, x);
+    BOOST_CHECK_SMALL(resid, 1e-6);
+
+    // The top level is the largest one stored. The strength of connections
+    // is only recorded when the level is aggregated.
+    BOOST_REQUIRE(store->levels.count(n));
+    const std::vector<float> strength = store->levels[n].strength;
+    const size_t             levels   = store->levels.size();
+    BOOST_CHECK_GT(levels, 1u);
+
+    // Small perturbation of the values: the aggregates are reused.
+    perturbed_problem(16, 0.01, false, val, col, ptr, rhs);
+    solve.rebuild(boost::tie(n, ptr, col, val));
+
+    BOOST_CHECK(store->levels[n].strength == strength);
+    BOOST_CHECK_EQUAL(store->levels.size(), levels);
+
+    std::fill(x.begin(), x.end(), 0.0);
+    boost::tie(iters, resid) = solve(rhs, x);
+    BOOST_CHECK_SMALL(resid, 1e-6);
+
+    // Strong anisotropy: the strength drifts past max_drift, and the
+    // hierarchy is re-aggregated.
+    perturbed_problem(16, 0.9, false, val, col, ptr, rhs);
+    solve.rebuild(boost::tie(n, ptr, col, val));
+
+    BOOST_CHECK(store->levels[n].strength != strength);
+
+    std::fill(x.begin(), x.end(), 0.0);
+    boost::tie(iters, resid) = solve(rhs, x);
+    BOOST_CHECK_SMALL(resid, 1e-6);
+
+    // New sparsity pattern: the hierarchy is re-aggregated.
+    perturbed_problem(16, 0.9, true, val, col, ptr, rhs);
+    solve.rebuild(boost::tie(n, ptr, col, val));
+
+    BOOST_CHECK_EQUAL(store->levels[n].nnz, val.size());
+
+    std::fill(x.begin(), x.end(), 0.0);
+    boost::tie(iters, resid) = solve(rhs, x);
+    BOOST_CHECK_SMALL(resid, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(test_aggressive_coarsening)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+
+    std::cout << "aggressive ruge_stuben" << std::endl;
+    test_aggressive<Backend>(amgcl::runtime::coarsening::ruge_stuben);
+
+    std::cout << "aggressive smoothed_aggregation" << std::endl;
+    test_aggressive<Backend>(amgcl::runtime::coarsening::smoothed_aggregation);
+}
+
 BOOST_AUTO_TEST_SUITE_END()